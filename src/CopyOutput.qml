@@ -9,7 +9,10 @@ OutputItem {
 
     required property PrimaryOutput targetOutputItem
     property OutputViewport screenViewport: targetOutputItem.screenViewport
+    // Kept around while the output is in extension mode, see RootContainer.
+    property bool active: true
 
+    visible: active
     devicePixelRatio: output?.scale ?? devicePixelRatio
 
     Rectangle {
@@ -51,7 +54,7 @@ OutputItem {
         depends: [screenViewport]
         devicePixelRatio: outputItem.devicePixelRatio
         input: content
-        output: outputItem.output
+        output: outputItem.active ? outputItem.output : null
         ignoreViewport: true
     }
 }
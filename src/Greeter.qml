@@ -174,7 +174,7 @@ Item {
         model: Helper.sessionModel
         textRole: "name"
         width: 200
-        visible: Helper.sessionModel.rowCount() > 1
+        visible: Helper.sessionModel.count > 1
         KeyNavigation.backtab: shutdown
         KeyNavigation.tab: user_entry
         onCurrentIndexChanged: {
@@ -201,19 +201,9 @@ Item {
         Label {
             id: timelb
             anchors.centerIn: parent
-            text: Qt.formatDateTime(new Date(), "HH:mm")
+            text: Qt.formatDateTime(WallClock.currentTime, "HH:mm")
             color: "white"
             horizontalAlignment: Text.AlignHCenter
         }
     }
-
-    Timer {
-        id: timetr
-        interval: 500
-        repeat: true
-        running: true
-        onTriggered: {
-            timelb.text = Qt.formatDateTime(new Date(), "HH:mm")
-        }
-    }
 }
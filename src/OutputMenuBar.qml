@@ -7,6 +7,7 @@ import WayGreet
 
 Item {
     required property PrimaryOutput output
+    required property QtObject stats
 
     width: output.width
     height: menuBar.contentHeight
@@ -101,6 +102,12 @@ Item {
                 }
             }
 
+            ToolButton {
+                text: "Stats"
+                checkable: true
+                onToggled: statsOverlay.visible = checked
+            }
+
             Label {
                 text: Helper.workspace.currentIndex
                 color: "red"
@@ -134,4 +141,31 @@ Item {
             }
         }
     }
+
+    Rectangle {
+        id: statsOverlay
+
+        visible: false
+        anchors.top: menuBar.bottom
+        anchors.right: menuBar.right
+        anchors.margins: 8
+        width: statsText.implicitWidth + 16
+        height: statsText.implicitHeight + 16
+        color: "#a0000000"
+        onVisibleChanged: stats.overlayVisible = visible
+
+        Label {
+            id: statsText
+
+            anchors.centerIn: parent
+            color: "white"
+            font.family: "monospace"
+            text: stats.outputName
+                  + "\nframes      " + stats.frames + " (" + stats.directScanoutFrames + " direct)"
+                  + "\ninterval    " + stats.frameInterval.toFixed(2) + " ms (max " + stats.maxFrameInterval.toFixed(2) + ")"
+                  + "\nrender cpu  " + stats.renderTime.toFixed(2) + " ms"
+                  + "\ncommit      " + stats.commitLatency.toFixed(2) + " ms"
+                  + "\nhw layers   " + stats.hardwareLayers.toFixed(1)
+        }
+    }
 }
@@ -10,7 +10,10 @@ OutputItem {
     id: rootOutputItem
     readonly property OutputViewport screenViewport: outputViewport
     property bool forceSoftwareCursor: false
+    // Kept around while the output mirrors another one, see RootContainer.
+    property bool active: true
 
+    visible: active
     devicePixelRatio: output?.scale ?? devicePixelRatio
 
     cursorDelegate: Cursor {
@@ -37,7 +40,7 @@ OutputItem {
     OutputViewport {
         id: outputViewport
 
-        output: rootOutputItem.output
+        output: rootOutputItem.active ? rootOutputItem.output : null
         devicePixelRatio: parent.devicePixelRatio
         anchors.centerIn: parent
 
@@ -88,7 +91,12 @@ OutputItem {
 
     Image {
         anchors.fill: parent
-        source: WayConfig.background
+        // Decoded once by BackgroundCache, outputs of the same size share the texture.
+        source: width > 0 && height > 0 ? "image://background/current" : ""
+        // What the provider scales "current" for.
+        fillMode: Image.Stretch
+        sourceSize: Qt.size(width * rootOutputItem.devicePixelRatio,
+                            height * rootOutputItem.devicePixelRatio)
     }
 
     function setTransform(transform) {
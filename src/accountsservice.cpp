@@ -0,0 +1,181 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "accountsservice.h"
+
+#include "wayconfig.h"
+
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QLoggingCategory>
+
+#include <utility>
+
+Q_LOGGING_CATEGORY(qLcAccounts, "waygreet.accounts")
+
+const QString ACCOUNTS_SERVICE = QStringLiteral("org.freedesktop.Accounts");
+const QString ACCOUNTS_PATH = QStringLiteral("/org/freedesktop/Accounts");
+const QString ACCOUNTS_INTERFACE = QStringLiteral("org.freedesktop.Accounts");
+const QString ACCOUNTS_USER_INTERFACE = QStringLiteral("org.freedesktop.Accounts.User");
+const QString PROPERTIES_INTERFACE = QStringLiteral("org.freedesktop.DBus.Properties");
+
+// org.freedesktop.Accounts.User.PasswordMode
+constexpr int PasswordModeNone = 2;
+
+AccountsService::AccountsService(const QDBusConnection &bus, QObject *parent)
+    : QObject(parent)
+    , m_bus(bus)
+{
+}
+
+QDBusConnection AccountsService::configuredBus()
+{
+    const QString bus = WayConfig::instance()->accountsServiceBus();
+    if (bus == QStringLiteral("system"))
+        return QDBusConnection::systemBus();
+    if (bus == QStringLiteral("session"))
+        return QDBusConnection::sessionBus();
+    // Otherwise the address of a private bus.
+    return QDBusConnection::connectToBus(bus, QStringLiteral("waygreet-accounts"));
+}
+
+void AccountsService::load()
+{
+    if (!m_bus.isConnected()) {
+        qCWarning(qLcAccounts) << "Not connected to the bus:" << m_bus.lastError().message();
+        Q_EMIT failed();
+        return;
+    }
+
+    // Subscribe first, users added while listing are fetched twice at worst.
+    m_bus.connect(ACCOUNTS_SERVICE,
+                  ACCOUNTS_PATH,
+                  ACCOUNTS_INTERFACE,
+                  QStringLiteral("UserAdded"),
+                  this,
+                  SLOT(onUserAdded(QDBusObjectPath)));
+    m_bus.connect(ACCOUNTS_SERVICE,
+                  ACCOUNTS_PATH,
+                  ACCOUNTS_INTERFACE,
+                  QStringLiteral("UserDeleted"),
+                  this,
+                  SLOT(onUserDeleted(QDBusObjectPath)));
+    // Any path, Changed is emitted by each user object.
+    m_bus.connect(ACCOUNTS_SERVICE,
+                  QString(),
+                  ACCOUNTS_USER_INTERFACE,
+                  QStringLiteral("Changed"),
+                  this,
+                  SLOT(onUserChanged(QDBusMessage)));
+
+    auto message = QDBusMessage::createMethodCall(ACCOUNTS_SERVICE,
+                                                  ACCOUNTS_PATH,
+                                                  ACCOUNTS_INTERFACE,
+                                                  QStringLiteral("ListCachedUsers"));
+    auto watcher = new QDBusPendingCallWatcher(m_bus.asyncCall(message), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, watcher] {
+        watcher->deleteLater();
+
+        QDBusPendingReply<QList<QDBusObjectPath>> reply = *watcher;
+        if (reply.isError()) {
+            qCWarning(qLcAccounts) << "Can't list users:" << reply.error().message();
+            Q_EMIT failed();
+            return;
+        }
+
+        const auto paths = reply.value();
+        qCDebug(qLcAccounts) << "Fetching" << paths.size() << "users";
+        m_listed = true;
+        for (const auto &path : paths)
+            fetchUser(path.path());
+        if (!m_pendingFetches)
+            fetchFinished();
+    });
+}
+
+QList<AccountsServiceUser> AccountsService::users() const
+{
+    return m_users.values();
+}
+
+void AccountsService::onUserAdded(const QDBusObjectPath &path)
+{
+    fetchUser(path.path());
+}
+
+void AccountsService::onUserDeleted(const QDBusObjectPath &path)
+{
+    const auto user = m_users.take(path.path());
+    if (m_loaded && !user.path.isEmpty())
+        Q_EMIT userRemoved(user);
+}
+
+void AccountsService::onUserChanged(const QDBusMessage &message)
+{
+    // Its initial properties may have been read before the change.
+    if (!m_loaded)
+        m_changedWhileLoading.insert(message.path());
+    else if (m_users.contains(message.path()))
+        fetchUser(message.path());
+}
+
+void AccountsService::fetchUser(const QString &path)
+{
+    auto message = QDBusMessage::createMethodCall(ACCOUNTS_SERVICE,
+                                                  path,
+                                                  PROPERTIES_INTERFACE,
+                                                  QStringLiteral("GetAll"));
+    message << ACCOUNTS_USER_INTERFACE;
+
+    // Replies of the initial list are only counted, loaded() reports them.
+    const bool initial = !m_loaded;
+    if (initial)
+        ++m_pendingFetches;
+    auto watcher = new QDBusPendingCallWatcher(m_bus.asyncCall(message), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, watcher, path, initial] {
+        watcher->deleteLater();
+
+        QDBusPendingReply<QVariantMap> reply = *watcher;
+        if (reply.isError()) {
+            // Usually deleted in the meantime.
+            qCDebug(qLcAccounts) << "Can't fetch" << path << reply.error().message();
+        } else {
+            const auto properties = reply.value();
+            AccountsServiceUser user;
+            user.path = path;
+            user.name = properties.value(QStringLiteral("UserName")).toString();
+            user.realName = properties.value(QStringLiteral("RealName")).toString();
+            user.homeDir = properties.value(QStringLiteral("HomeDirectory")).toString();
+            user.iconFile = properties.value(QStringLiteral("IconFile")).toString();
+            user.uid = properties.value(QStringLiteral("Uid")).toULongLong();
+            user.systemAccount = properties.value(QStringLiteral("SystemAccount")).toBool();
+            user.needsPassword =
+                properties.value(QStringLiteral("PasswordMode")).toInt() != PasswordModeNone;
+
+            const auto previous = m_users.value(path);
+            m_users.insert(path, user);
+            if (!initial) {
+                if (previous.path.isEmpty())
+                    Q_EMIT userAdded(user);
+                else
+                    Q_EMIT userChanged(previous, user);
+            }
+        }
+
+        if (initial && --m_pendingFetches == 0 && m_listed)
+            fetchFinished();
+    });
+}
+
+void AccountsService::fetchFinished()
+{
+    qCInfo(qLcAccounts) << "Loaded" << m_users.size() << "users";
+    m_loaded = true;
+    Q_EMIT loaded();
+
+    for (const auto &path : std::exchange(m_changedWhileLoading, {})) {
+        if (m_users.contains(path))
+            fetchUser(path);
+    }
+}
@@ -0,0 +1,69 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <QDBusConnection>
+#include <QDBusObjectPath>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+
+class QDBusMessage;
+
+struct AccountsServiceUser
+{
+    QString path;
+    QString name;
+    QString realName;
+    QString homeDir;
+    // Empty if the user has no icon set.
+    QString iconFile;
+    qulonglong uid{ 0 };
+    bool systemAccount{ false };
+    bool needsPassword{ true };
+};
+
+// Users known to org.freedesktop.Accounts, fetched asynchronously. Once
+// loaded() is emitted, users appearing, disappearing or changing on the
+// service are reported one by one. The bus is a parameter so a stand-in
+// service on a session bus can replace the system one.
+class AccountsService : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AccountsService(const QDBusConnection &bus, QObject *parent = nullptr);
+
+    // The bus named by WayConfig::accountsServiceBus().
+    static QDBusConnection configuredBus();
+
+    // Lists the cached users and fetches their properties, emits loaded()
+    // or failed() when done.
+    void load();
+    QList<AccountsServiceUser> users() const;
+
+Q_SIGNALS:
+    void loaded();
+    void failed();
+    void userAdded(const AccountsServiceUser &user);
+    void userRemoved(const AccountsServiceUser &user);
+    void userChanged(const AccountsServiceUser &previous, const AccountsServiceUser &user);
+
+private Q_SLOTS:
+    void onUserAdded(const QDBusObjectPath &path);
+    void onUserDeleted(const QDBusObjectPath &path);
+    void onUserChanged(const QDBusMessage &message);
+
+private:
+    void fetchUser(const QString &path);
+    void fetchFinished();
+
+    QDBusConnection m_bus;
+    QHash<QString, AccountsServiceUser> m_users;
+    // Properties requests still running for the initial list.
+    int m_pendingFetches{ 0 };
+    bool m_listed{ false };
+    bool m_loaded{ false };
+    // Changed while the initial list was fetched, refetched once loaded.
+    QSet<QString> m_changedWhileLoading;
+};
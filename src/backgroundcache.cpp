@@ -0,0 +1,314 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "backgroundcache.h"
+
+#include "wayconfig.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QLoggingCategory>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <cstring>
+
+Q_LOGGING_CATEGORY(qLcBackgroundCache, "waygreet.backgroundCache")
+
+// One pass of a box blur over `count` pixels, `in` and `out` may not overlap.
+static void boxBlurLine(const uchar *in, int inStride, uchar *out, int outStride, int count, int r)
+{
+    const int div = 2 * r + 1;
+    int sum[4] = {};
+    const auto pixel = [&](int i) {
+        return in + qBound(0, i, count - 1) * inStride;
+    };
+
+    for (int i = -r; i <= r; ++i) {
+        for (int c = 0; c < 4; ++c)
+            sum[c] += pixel(i)[c];
+    }
+
+    for (int i = 0; i < count; ++i) {
+        const uchar *add = pixel(i + r + 1);
+        const uchar *sub = pixel(i - r);
+        for (int c = 0; c < 4; ++c) {
+            out[i * outStride + c] = uchar(sum[c] / div);
+            sum[c] += add[c] - sub[c];
+        }
+    }
+}
+
+BackgroundCache::BackgroundCache(QObject *parent)
+    : QObject(parent)
+{
+    Q_ASSERT(!m_instance);
+    m_instance = this;
+
+    if (auto config = WayConfig::instance()) {
+        m_background = config->background().toLocalFile();
+        m_diskLimit = qint64(config->backgroundCacheLimit()) * 1024 * 1024;
+    }
+}
+
+BackgroundCache *BackgroundCache::instance()
+{
+    return m_instance;
+}
+
+QString BackgroundCache::cacheDir() const
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+        + QStringLiteral("/backgrounds");
+}
+
+QUrl BackgroundCache::variant(const QUrl &source, int blurRadius, int fillMode)
+{
+    // Themes pass plain paths as well as file urls.
+    QString path;
+    if (source.isLocalFile())
+        path = source.toLocalFile();
+    else if (source.scheme().isEmpty())
+        path = source.path();
+
+    const QFileInfo info(path);
+    if (path.isEmpty() || !info.isFile())
+        return source;
+
+    QUrl url;
+    url.setScheme(QStringLiteral("image"));
+    url.setHost(QStringLiteral("background"));
+    url.setPath(QStringLiteral("/variant/%1/%2%3")
+                    .arg(fillMode)
+                    .arg(qMax(0, blurRadius))
+                    .arg(info.absoluteFilePath()));
+    return url;
+}
+
+QImage BackgroundCache::render(const QString &path, const QSize &size, int fillMode, int blurRadius)
+{
+    const QFileInfo info(path);
+    if (!info.isFile())
+        return {};
+
+    // Tiled and padded images are shown at their own size.
+    const bool scales = !size.isEmpty() && fillMode >= Stretch && fillMode <= PreserveAspectCrop;
+    if (!scales && blurRadius <= 0) {
+        const QImage image = acquireSource(info.absoluteFilePath());
+        releaseSource(info.absoluteFilePath());
+        return image;
+    }
+
+    const QByteArray key = QStringLiteral("%1:%2:%3x%4:%5:%6")
+                               .arg(info.absoluteFilePath())
+                               .arg(info.lastModified().toMSecsSinceEpoch())
+                               .arg(scales ? size.width() : 0)
+                               .arg(scales ? size.height() : 0)
+                               .arg(scales ? fillMode : -1)
+                               .arg(blurRadius)
+                               .toUtf8();
+    const QString fileName = QDir(cacheDir()).filePath(
+        QString::fromLatin1(QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex())
+        + QStringLiteral(".png"));
+
+    QImage image;
+    if (QFile file(fileName); file.open(QIODevice::ReadOnly) && image.load(&file, "PNG")) {
+        // The mtime orders the entries for eviction.
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+        return image;
+    }
+
+    image = acquireSource(info.absoluteFilePath());
+    if (!image.isNull() && scales)
+        image = scaled(image, size, fillMode);
+    image = blurred(image, blurRadius);
+    releaseSource(info.absoluteFilePath());
+    if (image.isNull())
+        return image;
+
+    QDir().mkpath(cacheDir());
+    // QSaveFile never leaves a truncated entry behind if we die while writing.
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || !image.save(&file, "PNG") || !file.commit()) {
+        qCWarning(qLcBackgroundCache) << "Can't write background cache" << fileName
+                                      << file.errorString();
+        return image;
+    }
+
+    qCDebug(qLcBackgroundCache) << "Cached" << path << size << fillMode << blurRadius << "to"
+                                << fileName;
+    evictDiskCache();
+    return image;
+}
+
+void BackgroundCache::evictDiskCache()
+{
+    QMutexLocker locker(&m_diskMutex);
+    // Most recently used first.
+    const auto entries = QDir(cacheDir()).entryInfoList({ QStringLiteral("*.png") },
+                                                         QDir::Files,
+                                                         QDir::Time);
+    qint64 total = 0;
+    for (const auto &entry : entries) {
+        total += entry.size();
+        if (total > m_diskLimit && QFile::remove(entry.absoluteFilePath()))
+            qCDebug(qLcBackgroundCache) << "Evicted" << entry.fileName();
+    }
+}
+
+QImage BackgroundCache::acquireSource(const QString &path)
+{
+    QMutexLocker locker(&m_mutex);
+    Source &source = m_sources[path];
+    if (source.users++ > 0)
+        return source.image;
+
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+    source.image = reader.read();
+    if (source.image.isNull())
+        qCWarning(qLcBackgroundCache) << "Can't decode background" << path << reader.errorString();
+    return source.image;
+}
+
+void BackgroundCache::releaseSource(const QString &path)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_sources.find(path);
+    // Full resolution, the variants and m_images hold what is shown.
+    if (it != m_sources.end() && --it->users == 0)
+        m_sources.erase(it);
+}
+
+QImage BackgroundCache::image(const QSize &size)
+{
+    if (m_background.isEmpty())
+        return {};
+
+    const QString key = QStringLiteral("%1x%2").arg(size.width()).arg(size.height());
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_images.constFind(key);
+        if (it != m_images.cend())
+            return it.value();
+    }
+
+    // Same as the default Image.Stretch of PrimaryOutput.
+    const QImage image = render(m_background, size, Stretch, 0);
+
+    QMutexLocker locker(&m_mutex);
+    m_images.insert(key, image);
+    return image;
+}
+
+void BackgroundCache::clear()
+{
+    // Sources only live while a render uses them.
+    QMutexLocker locker(&m_mutex);
+    m_images.clear();
+}
+
+QImage BackgroundCache::scaled(const QImage &image, const QSize &size, int fillMode)
+{
+    if (fillMode == Stretch)
+        return image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    if (fillMode == PreserveAspectFit)
+        return image.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+    // Image.PreserveAspectCrop, so the variant exactly covers the item.
+    const QImage s =
+        image.scaled(size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+    return s.copy((s.width() - size.width()) / 2,
+                  (s.height() - size.height()) / 2,
+                  size.width(),
+                  size.height());
+}
+
+QImage BackgroundCache::blurred(const QImage &image, int radius)
+{
+    if (radius <= 0 || image.isNull())
+        return image;
+
+    QImage result = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    const int width = result.width();
+    const int height = result.height();
+    const int stride = result.bytesPerLine();
+    // Three box blur passes are close enough to a gaussian blur.
+    const int r = qMax(1, radius / 2);
+    QByteArray line(qMax(width, height) * 4, Qt::Uninitialized);
+    auto buffer = reinterpret_cast<uchar *>(line.data());
+
+    for (int pass = 0; pass < 3; ++pass) {
+        for (int y = 0; y < height; ++y) {
+            uchar *row = result.scanLine(y);
+            std::memcpy(buffer, row, width * 4);
+            boxBlurLine(buffer, 4, row, 4, width, r);
+        }
+
+        uchar *bits = result.bits();
+        for (int x = 0; x < width; ++x) {
+            uchar *column = bits + x * 4;
+            for (int y = 0; y < height; ++y)
+                std::memcpy(buffer + y * 4, column + y * stride, 4);
+            boxBlurLine(buffer, 4, column, stride, height, r);
+        }
+    }
+
+    return result;
+}
+
+namespace {
+
+class BackgroundImageResponse : public QQuickImageResponse, public QRunnable
+{
+public:
+    BackgroundImageResponse(const QString &id, const QSize &requestedSize)
+        : m_id(id)
+        , m_requestedSize(requestedSize)
+    {
+        // Deleted by the engine once finished() is handled.
+        setAutoDelete(false);
+    }
+
+    QQuickTextureFactory *textureFactory() const override
+    {
+        return QQuickTextureFactory::textureFactoryForImage(m_image);
+    }
+
+    void run() override
+    {
+        if (auto cache = BackgroundCache::instance()) {
+            if (m_id == QStringLiteral("current")) {
+                m_image = cache->image(m_requestedSize);
+            } else if (m_id.startsWith(QStringLiteral("variant/"))) {
+                // variant/<fillMode>/<blurRadius><absolute path>, the path's
+                // leading slash is the separator after the radius.
+                m_image = cache->render(QLatin1Char('/') + m_id.section(u'/', 3),
+                                        m_requestedSize,
+                                        m_id.section(u'/', 1, 1).toInt(),
+                                        m_id.section(u'/', 2, 2).toInt());
+            }
+        }
+        Q_EMIT finished();
+    }
+
+private:
+    QString m_id;
+    QSize m_requestedSize;
+    QImage m_image;
+};
+
+} // namespace
+
+QQuickImageResponse *BackgroundImageProvider::requestImageResponse(const QString &id,
+                                                                   const QSize &requestedSize)
+{
+    auto response =
+        new BackgroundImageResponse(QUrl::fromPercentEncoding(id.toUtf8()), requestedSize);
+    m_pool.start(response);
+    return response;
+}
@@ -0,0 +1,89 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QQmlEngine>
+#include <QQuickAsyncImageProvider>
+#include <QSize>
+#include <QThreadPool>
+
+class BackgroundCache : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_SINGLETON
+
+public:
+    // Same values as Image.fillMode.
+    enum FillMode {
+        Stretch,
+        PreserveAspectFit,
+        PreserveAspectCrop,
+    };
+
+    explicit BackgroundCache(QObject *parent = nullptr);
+    static BackgroundCache *instance();
+
+    // Returns an `image://background/variant` url of `source` blurred by
+    // `blurRadius`. The Image's sourceSize is the size it is scaled to as
+    // `fillMode` would, other fill modes keep the source size. Nothing is
+    // decoded here, the provider does it off the GUI thread.
+    Q_INVOKABLE QUrl variant(const QUrl &source, int blurRadius = 0, int fillMode = Stretch);
+
+    // `path` scaled to `size` as `fillMode` would and blurred by `blurRadius`.
+    // The result is written once to the cache directory, keyed by the source
+    // mtime, size, mode and radius. Called from the image provider's threads.
+    QImage render(const QString &path, const QSize &size, int fillMode, int blurRadius);
+
+    // The configured background stretched to `size`, shared by every output
+    // of that size.
+    QImage image(const QSize &size);
+    void clear();
+
+    static QImage scaled(const QImage &image, const QSize &size, int fillMode);
+    static QImage blurred(const QImage &image, int radius);
+
+private:
+    struct Source
+    {
+        QImage image;
+        // Renders still using it, it is dropped with the last one.
+        int users{ 0 };
+    };
+
+    // The decoded file, shared by variants of it rendered at the same time.
+    QImage acquireSource(const QString &path);
+    void releaseSource(const QString &path);
+    QString cacheDir() const;
+    void evictDiskCache();
+
+    QMutex m_mutex;
+    QHash<QString, Source> m_sources;
+    QHash<QString, QImage> m_images;
+    // Read on the GUI thread, WayConfig isn't used from the provider's threads.
+    QString m_background;
+    qint64 m_diskLimit{ 0 };
+    QMutex m_diskMutex;
+
+    inline static BackgroundCache *m_instance = nullptr;
+};
+
+// Serves `image://background/current`, the configured background, and the
+// urls of BackgroundCache::variant(). Images are decoded, scaled and blurred
+// on a worker thread. QQuickPixmapCache shares the result between all Image
+// items with the same url and sourceSize, so outputs of one size share one
+// texture.
+class BackgroundImageProvider : public QQuickAsyncImageProvider
+{
+public:
+    QQuickImageResponse *requestImageResponse(const QString &id,
+                                              const QSize &requestedSize) override;
+
+private:
+    QThreadPool m_pool;
+};
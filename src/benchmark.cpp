@@ -0,0 +1,465 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchmark.h"
+
+#include "framestats.h"
+#include "helper.h"
+#include "idlemanager.h"
+#include "memoryusage.h"
+#include "output.h"
+#include "sessionmodel.h"
+#include "wayconfig.h"
+
+#include <wcursor.h>
+#include <woutput.h>
+#include <woutputitem.h>
+#include <woutputlayout.h>
+#include <woutputrenderwindow.h>
+
+#include <qwoutput.h>
+#include <qwoutputlayout.h>
+
+#include <QGuiApplication>
+#include <QLoggingCategory>
+#include <QPointer>
+#include <QSaveFile>
+#include <QTemporaryDir>
+#include <QQuickItem>
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+Q_LOGGING_CATEGORY(qLcBenchmark, "waygreet.benchmark")
+
+static qreal toMs(qint64 ns)
+{
+    return ns / 1000000.0;
+}
+
+static QString summary(QList<qint64> times)
+{
+    if (times.isEmpty())
+        return QStringLiteral("-");
+
+    std::sort(times.begin(), times.end());
+    const qint64 total = std::accumulate(times.cbegin(), times.cend(), qint64(0));
+    return QStringLiteral("min/median/avg/max: %1 %2 %3 %4 ms")
+        .arg(toMs(times.first()))
+        .arg(toMs(times.at(times.size() / 2)))
+        .arg(toMs(total / times.size()))
+        .arg(toMs(times.last()));
+}
+
+static void countItems(QQuickItem *item, int &items, int &contentItems)
+{
+    if (!item->isVisible())
+        return;
+
+    ++items;
+    // Items that create a paint node, a lower bound of the scene graph nodes.
+    if (item->flags().testFlag(QQuickItem::ItemHasContents))
+        ++contentItems;
+
+    for (auto child : item->childItems())
+        countItems(child, items, contentItems);
+}
+
+ThemeBenchmark::ThemeBenchmark(Helper *helper, int frames, QObject *parent)
+    : QObject(parent)
+    , m_helper(helper)
+    , m_frames(qMax(1, frames))
+{
+    m_frameCpuTimes.reserve(m_frames);
+}
+
+void ThemeBenchmark::setupHeadlessBackend()
+{
+    // No GPU and no input devices, only what the theme itself costs.
+    qputenv("WLR_BACKENDS", "headless");
+    qputenv("WLR_LIBINPUT_NO_DEVICES", "1");
+    qputenv("WLR_RENDERER", "pixman");
+}
+
+void ThemeBenchmark::start()
+{
+    auto window = m_helper->window();
+    connect(window, &QQuickWindow::beforeSynchronizing, this, &ThemeBenchmark::frameStarted);
+    connect(window, &QQuickWindow::afterRendering, this, &ThemeBenchmark::frameRendered);
+
+    m_timer.start();
+    m_helper->addFakeOutput();
+}
+
+void ThemeBenchmark::frameStarted()
+{
+    m_frameCpuStart = FrameStats::threadCpuTimeNs();
+}
+
+void ThemeBenchmark::frameRendered()
+{
+    // Frames before the greeter exists only show the output background.
+    if (!m_helper->greeter())
+        return;
+
+    if (m_firstFrameTime < 0)
+        m_firstFrameTime = m_timer.nsecsElapsed();
+    else
+        m_frameCpuTimes.append(FrameStats::threadCpuTimeNs() - m_frameCpuStart);
+
+    if (m_frameCpuTimes.size() >= m_frames) {
+        disconnect(m_helper->window(), nullptr, this, nullptr);
+        report();
+        qApp->quit();
+        return;
+    }
+
+    // Keep the render loop busy even if the theme has no animation running.
+    auto window = m_helper->window();
+    QMetaObject::invokeMethod(
+        window,
+        [window] {
+            window->update();
+        },
+        Qt::QueuedConnection);
+}
+
+void ThemeBenchmark::report()
+{
+    int items = 0;
+    int contentItems = 0;
+    countItems(m_helper->greeter(), items, contentItems);
+
+    const QString theme = WayConfig::instance()->theme();
+    qCInfo(qLcBenchmark).noquote() << "theme:" << (theme.isEmpty() ? "<builtin>" : theme);
+    qCInfo(qLcBenchmark).noquote() << "time to first frame:" << toMs(m_firstFrameTime) << "ms";
+    qCInfo(qLcBenchmark).noquote() << "frames:" << m_frameCpuTimes.size() << "cpu"
+                                   << summary(m_frameCpuTimes);
+    qCInfo(qLcBenchmark).noquote() << "items:" << items << "items with content:"
+                                   << contentItems;
+}
+
+HotplugBenchmark::HotplugBenchmark(Helper *helper, int cycles, QObject *parent)
+    : QObject(parent)
+    , m_helper(helper)
+    , m_cycles(qMax(1, cycles))
+{
+    m_pollTimer.setInterval(1);
+    connect(&m_pollTimer, &QTimer::timeout, this, [this] {
+        m_maxStall = qMax(m_maxStall, m_pollGap.nsecsElapsed());
+        m_pollGap.start();
+        if (m_condition()) {
+            m_pollTimer.stop();
+            // May start waiting for the next condition.
+            std::exchange(m_then, nullptr)();
+        } else if (m_waitTimer.elapsed() > 5000) {
+            m_pollTimer.stop();
+            check(false, "timed out waiting for outputs to show a frame");
+            finish();
+        }
+    });
+}
+
+void HotplugBenchmark::start()
+{
+    // Two outputs to begin with, RootContainer ignores mode switches below that.
+    addOutput();
+    addOutput();
+    waitFor(
+        [this] {
+            return m_helper->greeter() && allOutputsShown();
+        },
+        [this] {
+            startMode(RootContainer::OutputMode::Extension);
+        });
+}
+
+WOutput *HotplugBenchmark::addOutput()
+{
+    WOutput *output = m_helper->addFakeOutput();
+    Q_ASSERT(output);
+    return output;
+}
+
+void HotplugBenchmark::waitFor(std::function<bool()> condition, std::function<void()> then)
+{
+    m_condition = std::move(condition);
+    m_then = std::move(then);
+    m_waitTimer.start();
+    m_pollGap.start();
+    m_maxStall = 0;
+    m_pollTimer.start();
+}
+
+bool HotplugBenchmark::allOutputsShown() const
+{
+    const auto &outputs = m_helper->rootContainer()->outputs();
+    return std::all_of(outputs.cbegin(), outputs.cend(), [](Output *o) {
+        return o->hasFrame();
+    });
+}
+
+void HotplugBenchmark::check(bool ok, const char *what)
+{
+    if (ok)
+        return;
+
+    ++m_failures;
+    qCWarning(qLcBenchmark) << "check failed in cycle" << m_cycle << m_mode << ":" << what;
+}
+
+void HotplugBenchmark::startMode(RootContainer::OutputMode mode)
+{
+    m_mode = mode;
+    m_cycle = 0;
+    m_addTimes.clear();
+    m_addStalls.clear();
+    m_removeTimes.clear();
+
+    auto container = m_helper->rootContainer();
+    container->setOutputMode(mode);
+    check(container->outputMode() == mode, "output mode not switched");
+
+    waitFor(
+        [this] {
+            return allOutputsShown();
+        },
+        [this] {
+            // Also counts the standby outputs created by the mode switch.
+            m_baseResident = MemoryUsage::residentBytes();
+            m_baseOutputs = Output::liveCount();
+            nextCycle();
+        });
+}
+
+void HotplugBenchmark::nextCycle()
+{
+    if (m_cycle == m_cycles) {
+        reportMode();
+        if (m_mode == RootContainer::OutputMode::Extension)
+            startMode(RootContainer::OutputMode::Copy);
+        else
+            finish();
+        return;
+    }
+
+    m_timer.start();
+    QPointer<WOutput> added = addOutput();
+    // Outputs created synchronously block here, incubated ones between polls.
+    const qint64 addCall = m_timer.nsecsElapsed();
+    waitFor(
+        [this, added] {
+            auto o = added ? m_helper->rootContainer()->getOutput(added) : nullptr;
+            return o && o->hasFrame();
+        },
+        [this, added, addCall] {
+            m_addTimes.append(m_timer.nsecsElapsed());
+            m_addStalls.append(qMax(addCall, m_maxStall));
+            check(m_helper->rootContainer()->outputs().size() == 3, "added output not registered");
+
+            // Alternate, so the primary output is unplugged every other cycle.
+            auto primary = m_helper->rootContainer()->primaryOutput();
+            removeOutput(m_cycle % 2 ? primary->output() : added.data());
+        });
+}
+
+void HotplugBenchmark::removeOutput(WOutput *output)
+{
+    auto container = m_helper->rootContainer();
+    auto o = container->getOutput(output);
+    const bool wasPrimary = o == container->primaryOutput();
+    // Off center, it should keep its position relative to the new output.
+    m_helper->setCursorPosition(o->geometry().topLeft() + QPointF(100, 100));
+
+    m_timer.start();
+    wlr_output_destroy(output->nativeHandle());
+    m_removeTimes.append(m_timer.nsecsElapsed());
+
+    auto primary = container->primaryOutput();
+    check(container->getOutput(output) == nullptr, "removed output still registered");
+    check(container->outputs().size() == 2, "wrong number of outputs left");
+    check(primary && primary->isPrimary(), "no primary output left");
+    if (wasPrimary && primary) {
+        // Copy outputs must have been re-targeted to the new primary output.
+        for (auto other : container->outputs())
+            check(other->isPrimary() || other->proxy() == primary, "copy output lost its source");
+    }
+
+    const auto cursorPos = container->cursor()->position();
+    check(container->outputLayout()->handle()->output_at(cursorPos.x(), cursorPos.y()),
+          "cursor left outside of all outputs");
+
+    waitFor(
+        [this] {
+            return allOutputsShown();
+        },
+        [this] {
+            // Let the deferred deletions run before counting.
+            QMetaObject::invokeMethod(
+                this,
+                [this] {
+                    check(Output::liveCount() == m_baseOutputs, "Output objects leaked");
+                    ++m_cycle;
+                    nextCycle();
+                },
+                Qt::QueuedConnection);
+        });
+}
+
+void HotplugBenchmark::reportMode()
+{
+    int outputItems = 0;
+    for (auto item : m_helper->window()->contentItem()->childItems()) {
+        if (qobject_cast<WOutputItem *>(item))
+            ++outputItems;
+    }
+
+    const qint64 resident = MemoryUsage::residentBytes();
+    qCInfo(qLcBenchmark).noquote() << "mode:" << m_mode << "cycles:" << m_cycles;
+    qCInfo(qLcBenchmark).noquote() << "plug in to first frame" << summary(m_addTimes);
+    qCInfo(qLcBenchmark).noquote() << "longest GUI thread stall while plugging in"
+                                   << summary(m_addStalls);
+    qCInfo(qLcBenchmark).noquote() << "unplug" << summary(m_removeTimes);
+    qCInfo(qLcBenchmark).noquote()
+        << "resident memory:" << m_baseResident / 1024 << "->" << resident / 1024 << "KiB,"
+        << (resident - m_baseResident) / m_cycles << "bytes per cycle";
+    qCInfo(qLcBenchmark).noquote() << "Output objects:" << m_baseOutputs << "->"
+                                   << Output::liveCount() << "output items:" << outputItems;
+}
+
+void HotplugBenchmark::finish()
+{
+    qCInfo(qLcBenchmark).noquote() << "failed checks:" << m_failures;
+    qApp->exit(m_failures ? 1 : 0);
+}
+
+IdleBenchmark::IdleBenchmark(Helper *helper, int seconds, QObject *parent)
+    : QObject(parent)
+    , m_helper(helper)
+    , m_seconds(qMax(1, seconds))
+{
+    // What an animated theme would ask for while the outputs are off.
+    m_updateTimer.setInterval(16);
+    connect(&m_updateTimer, &QTimer::timeout, this, [this] {
+        m_helper->window()->update();
+    });
+}
+
+void IdleBenchmark::start()
+{
+    connect(m_helper->window(), &QQuickWindow::afterRendering, this, [this] {
+        if (!m_helper->greeter())
+            return;
+
+        disconnect(m_helper->window(), nullptr, this, nullptr);
+        auto idleManager = m_helper->idleManager();
+        connect(idleManager, &IdleManager::idleChanged, this, &IdleBenchmark::idleChanged);
+        // Regardless of idleTimeout, there is no input on the headless backend.
+        idleManager->setTimeout(100);
+    });
+
+    m_helper->addFakeOutput();
+}
+
+void IdleBenchmark::idleChanged()
+{
+    if (!m_helper->idleManager()->isIdle())
+        return;
+
+    qCInfo(qLcBenchmark).noquote() << "idle, requesting frames for" << m_seconds << "s";
+    m_updateTimer.start();
+    QTimer::singleShot(m_seconds * 1000, this, &IdleBenchmark::wakeUp);
+}
+
+void IdleBenchmark::wakeUp()
+{
+    m_updateTimer.stop();
+    auto idleManager = m_helper->idleManager();
+    m_framesWhileIdle = idleManager->framesWhileIdle();
+    disconnect(idleManager, nullptr, this, nullptr);
+    idleManager->setTimeout(0);
+
+    m_timer.start();
+    connect(
+        m_helper->window(),
+        &QQuickWindow::afterRendering,
+        this,
+        [this] {
+            finish(true);
+        },
+        Qt::SingleShotConnection);
+    QTimer::singleShot(5000, this, [this] {
+        finish(false);
+    });
+    idleManager->notifyActivity();
+    m_helper->window()->update();
+}
+
+void IdleBenchmark::finish(bool woke)
+{
+    if (std::exchange(m_finished, true))
+        return;
+
+    if (woke)
+        qCInfo(qLcBenchmark).noquote()
+            << "first frame after wake up:" << toMs(m_timer.nsecsElapsed()) << "ms";
+    else
+        qCWarning(qLcBenchmark) << "no frame within 5 s after wake up";
+    qCInfo(qLcBenchmark).noquote() << "frames rendered while idle:" << m_framesWhileIdle;
+    qApp->exit(woke && m_framesWhileIdle == 0 ? 0 : 1);
+}
+
+int SessionBenchmark::run(int sessions)
+{
+    sessions = qMax(1, sessions);
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        qCWarning(qLcBenchmark) << "Can't create session directory:" << dir.errorString();
+        return 1;
+    }
+
+    for (int i = 0; i < sessions; ++i) {
+        QSaveFile file(dir.filePath(QStringLiteral("session-%1.desktop").arg(i)));
+        if (!file.open(QIODevice::WriteOnly))
+            return 1;
+        // Every name twice, and the directory is read as both session types.
+        file.write(QStringLiteral("[Desktop Entry]\n"
+                                  "Name=Session %1\n"
+                                  "Comment=Generated by waygreet --benchmark-sessions\n"
+                                  "Exec=/bin/sh\n"
+                                  "TryExec=/bin/sh\n"
+                                  "Type=Application\n")
+                       .arg(i / 2)
+                       .toUtf8());
+        if (!file.commit())
+            return 1;
+    }
+    WayConfig::instance()->setSessionDirOverride(dir.path());
+    // Off by default, the directory is read as both session types only with it.
+    WayConfig::instance()->setShowX11SessionOverride(true);
+
+    QElapsedTimer timer;
+    SessionModel model;
+    timer.start();
+    model.load();
+    const qint64 loadTime = timer.nsecsElapsed();
+
+    // Like a combo box, which asks for the name of every row on each change.
+    constexpr int passes = 10;
+    int bytes = 0;
+    timer.start();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (int row = 0; row < model.rowCount(); ++row)
+            bytes += model.data(model.index(row), SessionModel::NameRole).toString().size();
+    }
+    const qint64 lookupTime = timer.nsecsElapsed();
+    const int lookups = passes * model.rowCount();
+
+    qCInfo(qLcBenchmark).noquote() << "session files:" << sessions << "rows:" << model.rowCount();
+    qCInfo(qLcBenchmark).noquote() << "load:" << toMs(loadTime) << "ms";
+    qCInfo(qLcBenchmark).noquote()
+        << "name lookups:" << lookups << "in" << toMs(lookupTime) << "ms,"
+        << (lookups ? lookupTime / lookups : 0) << "ns each (" << bytes << "chars)";
+    return 0;
+}
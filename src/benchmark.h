@@ -0,0 +1,117 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "rootcontainer.h"
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+
+#include <functional>
+
+class Helper;
+
+// Renders the configured theme on a headless output for a fixed number of
+// frames and prints where the time went, see `waygreet --benchmark-frames`.
+class ThemeBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ThemeBenchmark(Helper *helper, int frames, QObject *parent = nullptr);
+
+    // Must be called before Helper::init(), the renderer is chosen there.
+    static void setupHeadlessBackend();
+
+    void start();
+
+private:
+    void frameStarted();
+    void frameRendered();
+    void report();
+
+    Helper *m_helper;
+    int m_frames;
+    QElapsedTimer m_timer;
+    qint64 m_firstFrameTime = -1;
+    qint64 m_frameCpuStart = 0;
+    QList<qint64> m_frameCpuTimes;
+};
+
+// Plugs headless outputs in and out in extension and copy mode, checks that
+// the primary output and the cursor are moved off removed outputs and that
+// no Output is leaked, see `waygreet --benchmark-hotplug`.
+class HotplugBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    explicit HotplugBenchmark(Helper *helper, int cycles, QObject *parent = nullptr);
+
+    void start();
+
+private:
+    WOutput *addOutput();
+    void waitFor(std::function<bool()> condition, std::function<void()> then);
+    bool allOutputsShown() const;
+    void check(bool ok, const char *what);
+
+    void startMode(RootContainer::OutputMode mode);
+    void nextCycle();
+    void removeOutput(WOutput *output);
+    void reportMode();
+    void finish();
+
+    Helper *m_helper;
+    int m_cycles;
+    int m_cycle = 0;
+    int m_failures = 0;
+    RootContainer::OutputMode m_mode = RootContainer::OutputMode::Extension;
+
+    QTimer m_pollTimer;
+    QElapsedTimer m_waitTimer;
+    // Longest gap between two polls, the GUI thread was blocked meanwhile.
+    QElapsedTimer m_pollGap;
+    qint64 m_maxStall = 0;
+    std::function<bool()> m_condition;
+    std::function<void()> m_then;
+
+    QElapsedTimer m_timer;
+    QList<qint64> m_addTimes;
+    QList<qint64> m_addStalls;
+    QList<qint64> m_removeTimes;
+    qint64 m_baseResident = 0;
+    int m_baseOutputs = 0;
+};
+
+// Lets the outputs go idle, keeps requesting frames for <seconds> and fails
+// if any is rendered before input wakes them up, see `waygreet --benchmark-idle`.
+class IdleBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    explicit IdleBenchmark(Helper *helper, int seconds, QObject *parent = nullptr);
+
+    void start();
+
+private:
+    void idleChanged();
+    void wakeUp();
+    void finish(bool woke);
+
+    Helper *m_helper;
+    int m_seconds;
+    int m_framesWhileIdle = 0;
+    bool m_finished = false;
+    QTimer m_updateTimer;
+    QElapsedTimer m_timer;
+};
+
+// Loads <sessions> generated session files, half of them with a duplicate
+// name, and times SessionModel, see `waygreet --benchmark-sessions`.
+class SessionBenchmark
+{
+public:
+    static int run(int sessions);
+};
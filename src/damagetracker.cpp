@@ -0,0 +1,60 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "damagetracker.h"
+
+#include "output.h"
+#include "rootcontainer.h"
+
+#include <woutputrenderwindow.h>
+#include <woutputviewport.h>
+
+#include <QHash>
+#include <QSet>
+#include <private/qquickitem_p.h>
+#include <private/qquickwindow_p.h>
+
+DamageTracker::DamageTracker(WOutputRenderWindow *window, RootContainer *container, QObject *parent)
+    : QObject(parent)
+    , m_window(window)
+    , m_container(container)
+{
+    // Emitted from polishItems(), before the viewports are synced and rendered.
+    connect(m_window, &QQuickWindow::afterAnimating, this, &DamageTracker::collectDamage);
+}
+
+void DamageTracker::collectDamage()
+{
+    // Outputs are off, IdleManager keeps their viewports paused.
+    if (!m_container->outputsPowered())
+        return;
+
+    const auto &outputs = m_container->outputs();
+    QHash<QQuickItem *, Output *> outputOfItem;
+    for (auto o : outputs)
+        outputOfItem.insert(o->outputItem(), o);
+
+    QSet<Output *> damaged;
+    bool damageAll = false;
+    auto wd = QQuickWindowPrivate::get(m_window);
+    for (QQuickItem *item = wd->dirtyItemList; item;
+         item = QQuickItemPrivate::get(item)->nextDirtyItem) {
+        QQuickItem *p = item;
+        while (p && !outputOfItem.contains(p))
+            p = p->parentItem();
+
+        if (!p) {
+            // Outside of any output, e.g. the debug menu bar, can't tell.
+            damageAll = true;
+            break;
+        }
+        damaged.insert(outputOfItem.value(p));
+    }
+
+    for (auto o : outputs) {
+        const bool dirty = damageAll || !o->hasFrame() || damaged.contains(o)
+            || (o->proxy() && damaged.contains(o->proxy()));
+        // A direct scanout mirror gets its buffer from the primary output.
+        o->renderViewport()->setLive(dirty && !o->isDirectScanout());
+    }
+}
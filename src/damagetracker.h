@@ -0,0 +1,34 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <wglobal.h>
+
+#include <QObject>
+
+WAYLIB_SERVER_BEGIN_NAMESPACE
+class WOutputRenderWindow;
+WAYLIB_SERVER_END_NAMESPACE
+
+WAYLIB_SERVER_USE_NAMESPACE
+
+class RootContainer;
+
+// All outputs share one WOutputRenderWindow, so any change in the scene
+// would repaint every monitor. Before each frame this maps the window's dirty
+// items to the outputs containing them, and only keeps those viewports live.
+class DamageTracker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DamageTracker(WOutputRenderWindow *window,
+                           RootContainer *container,
+                           QObject *parent = nullptr);
+
+private:
+    void collectDamage();
+
+    WOutputRenderWindow *m_window;
+    RootContainer *m_container;
+};
@@ -0,0 +1,176 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "framestats.h"
+
+#include "wayconfig.h"
+
+#include <woutput.h>
+#include <woutputrenderwindow.h>
+#include <woutputviewport.h>
+
+#include <qwoutput.h>
+
+#include <QJsonDocument>
+#include <QLoggingCategory>
+
+#include <time.h>
+
+Q_LOGGING_CATEGORY(qLcFrameStats, "waygreet.frameStats")
+
+static qint64 monotonicNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static qreal toMs(qreal ns)
+{
+    return ns / 1000000.0;
+}
+
+FrameStats::FrameStats(WOutput *output,
+                       WOutputViewport *viewport,
+                       WOutputRenderWindow *window,
+                       QObject *parent)
+    : QObject(parent)
+    , m_output(output)
+    , m_viewport(viewport)
+{
+    // All viewports are rendered in one pass of the window, the pass is
+    // accounted to every output committing a frame from it.
+    connect(window, &QQuickWindow::beforeSynchronizing, this, [this] {
+        m_renderStartCpu = threadCpuTimeNs();
+    });
+    connect(window, &QQuickWindow::afterRendering, this, [this] {
+        m_renderCpu = threadCpuTimeNs() - m_renderStartCpu;
+        m_renderEnd = monotonicNs();
+    });
+
+    output->handle()->safeConnect(&qw_output::notify_commit,
+                                  this,
+                                  [this](wlr_output_event_commit *event) {
+                                      if (event->state->committed & WLR_OUTPUT_STATE_BUFFER)
+                                          frameCommitted();
+                                  });
+
+    // Throttled, every update of an overlay bound to us is a frame itself.
+    m_updateTimer.setInterval(1000);
+    connect(&m_updateTimer, &QTimer::timeout, this, &FrameStats::updated);
+
+    if (const int interval = WayConfig::instance()->frameStatsDumpInterval(); interval > 0) {
+        m_dumpTimer.setInterval(interval * 1000);
+        connect(&m_dumpTimer, &QTimer::timeout, this, [this] {
+            if (!m_viewport->isVisible())
+                return;
+            qCInfo(qLcFrameStats).noquote()
+                << QJsonDocument(toJson()).toJson(QJsonDocument::Compact);
+        });
+        m_dumpTimer.start();
+    }
+}
+
+qint64 FrameStats::threadCpuTimeNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+void FrameStats::frameCommitted()
+{
+    // An inactive representation of the output, see Output::setActive().
+    if (!m_viewport->isVisible())
+        return;
+
+    const qint64 now = monotonicNs();
+    if (m_lastCommit > 0)
+        m_frameIntervals.append(now - m_lastCommit);
+    m_lastCommit = now;
+
+    m_renderTimes.append(m_renderCpu);
+    m_commitLatencies.append(m_renderEnd > 0 ? now - m_renderEnd : 0);
+    m_hardwareLayers.append(m_viewport->hardwareLayers().size());
+    ++m_frames;
+}
+
+QString FrameStats::outputName() const
+{
+    return m_output->name();
+}
+
+qreal FrameStats::frameInterval() const
+{
+    return toMs(m_frameIntervals.average());
+}
+
+qreal FrameStats::maxFrameInterval() const
+{
+    return toMs(m_frameIntervals.maximum());
+}
+
+qreal FrameStats::renderTime() const
+{
+    return toMs(m_renderTimes.average());
+}
+
+qreal FrameStats::commitLatency() const
+{
+    return toMs(m_commitLatencies.average());
+}
+
+qreal FrameStats::hardwareLayers() const
+{
+    return m_hardwareLayers.average();
+}
+
+int FrameStats::frames() const
+{
+    return m_frames;
+}
+
+int FrameStats::directScanoutFrames() const
+{
+    return m_directScanoutFrames;
+}
+
+void FrameStats::addDirectScanoutFrame()
+{
+    ++m_directScanoutFrames;
+}
+
+bool FrameStats::overlayVisible() const
+{
+    return m_updateTimer.isActive();
+}
+
+void FrameStats::setOverlayVisible(bool visible)
+{
+    if (visible == m_updateTimer.isActive())
+        return;
+
+    if (visible) {
+        m_updateTimer.start();
+        // Not a second late with what was recorded while hidden.
+        Q_EMIT updated();
+    } else {
+        m_updateTimer.stop();
+    }
+}
+
+QJsonObject FrameStats::toJson() const
+{
+    return {
+        { "output", outputName() },
+        { "frames", frames() },
+        { "directScanoutFrames", directScanoutFrames() },
+        { "samples", m_frameIntervals.count() },
+        { "frameIntervalMs", frameInterval() },
+        { "maxFrameIntervalMs", maxFrameInterval() },
+        { "renderCpuMs", renderTime() },
+        { "maxRenderCpuMs", toMs(m_renderTimes.maximum()) },
+        { "commitLatencyMs", commitLatency() },
+        { "hardwareLayers", hardwareLayers() },
+    };
+}
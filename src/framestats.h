@@ -0,0 +1,125 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <wglobal.h>
+
+#include <QJsonObject>
+#include <QObject>
+#include <QQmlEngine>
+#include <QTimer>
+
+#include <array>
+
+WAYLIB_SERVER_BEGIN_NAMESPACE
+class WOutput;
+class WOutputRenderWindow;
+class WOutputViewport;
+WAYLIB_SERVER_END_NAMESPACE
+
+WAYLIB_SERVER_USE_NAMESPACE
+
+template<typename T, int N>
+class RingBuffer
+{
+public:
+    void append(T value)
+    {
+        m_values[m_next] = value;
+        m_next = (m_next + 1) % N;
+        m_count = qMin(m_count + 1, N);
+    }
+
+    int count() const { return m_count; }
+
+    qreal average() const
+    {
+        if (!m_count)
+            return 0;
+        T sum = T();
+        for (int i = 0; i < m_count; ++i)
+            sum += m_values[i];
+        return qreal(sum) / m_count;
+    }
+
+    T maximum() const
+    {
+        T max = T();
+        for (int i = 0; i < m_count; ++i)
+            max = qMax(max, m_values[i]);
+        return max;
+    }
+
+private:
+    std::array<T, N> m_values{};
+    int m_next = 0;
+    int m_count = 0;
+};
+
+// Per output render statistics of the last FrameStats::Samples frames.
+// Times are in milliseconds, properties update at most once per second.
+class FrameStats : public QObject
+{
+    Q_OBJECT
+    QML_ANONYMOUS
+    Q_PROPERTY(QString outputName READ outputName CONSTANT FINAL)
+    Q_PROPERTY(qreal frameInterval READ frameInterval NOTIFY updated FINAL)
+    Q_PROPERTY(qreal maxFrameInterval READ maxFrameInterval NOTIFY updated FINAL)
+    Q_PROPERTY(qreal renderTime READ renderTime NOTIFY updated FINAL)
+    Q_PROPERTY(qreal commitLatency READ commitLatency NOTIFY updated FINAL)
+    Q_PROPERTY(qreal hardwareLayers READ hardwareLayers NOTIFY updated FINAL)
+    Q_PROPERTY(int frames READ frames NOTIFY updated FINAL)
+    Q_PROPERTY(int directScanoutFrames READ directScanoutFrames NOTIFY updated FINAL)
+    Q_PROPERTY(bool overlayVisible READ overlayVisible WRITE setOverlayVisible FINAL)
+
+public:
+    static constexpr int Samples = 256;
+
+    explicit FrameStats(WOutput *output,
+                        WOutputViewport *viewport,
+                        WOutputRenderWindow *window,
+                        QObject *parent = nullptr);
+
+    static qint64 threadCpuTimeNs();
+
+    QString outputName() const;
+    qreal frameInterval() const;
+    qreal maxFrameInterval() const;
+    qreal renderTime() const;
+    qreal commitLatency() const;
+    qreal hardwareLayers() const;
+    int frames() const;
+    // Frames of a copy output showing the primary output's buffer directly.
+    int directScanoutFrames() const;
+    void addDirectScanoutFrame();
+
+    // updated() is only emitted while an overlay shows the statistics.
+    bool overlayVisible() const;
+    void setOverlayVisible(bool visible);
+
+    QJsonObject toJson() const;
+
+Q_SIGNALS:
+    void updated();
+
+private:
+    void frameCommitted();
+
+    WOutput *m_output;
+    WOutputViewport *m_viewport;
+    QTimer m_updateTimer;
+    QTimer m_dumpTimer;
+
+    qint64 m_renderStartCpu = 0;
+    qint64 m_renderCpu = 0;
+    qint64 m_renderEnd = 0;
+    qint64 m_lastCommit = 0;
+    int m_frames = 0;
+    int m_directScanoutFrames = 0;
+
+    RingBuffer<qint64, Samples> m_frameIntervals;
+    RingBuffer<qint64, Samples> m_renderTimes;
+    RingBuffer<qint64, Samples> m_commitLatencies;
+    RingBuffer<int, Samples> m_hardwareLayers;
+};
@@ -6,10 +6,17 @@
 
 #include "helper.h"
 
+#include "backgroundcache.h"
+#include "damagetracker.h"
+#include "idlemanager.h"
 #include "ipc.h"
+#include "memoryusage.h"
+#include "powermanager.h"
 #include "sessionipc.h"
 #include "qmlengine.h"
 #include "rootcontainer.h"
+#include "startuptrace.h"
+#include "wayconfig.h"
 
 #include <WBackend>
 #include <WOutput>
@@ -17,6 +24,7 @@
 #include <woutputmanagerv1.h>
 #include <woutputrenderwindow.h>
 #include <woutputitem.h>
+#include <wcursor.h>
 #include <wquickcursor.h>
 #include <wrenderhelper.h>
 #include <wseat.h>
@@ -26,6 +34,7 @@
 #include <qwoutput.h>
 #include <qwrenderer.h>
 
+#include <QElapsedTimer>
 #include <QGuiApplication>
 #include <QKeySequence>
 #include <QLoggingCategory>
@@ -36,11 +45,18 @@
 #include <QQuickItem>
 #include <QQuickWindow>
 
+#include <memory>
+#include <time.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include <utility>
+
 Helper::Helper(QObject *parent)
     : WSeatEventFilter(parent)
     , m_sessionModel(new SessionModel(this))
     , m_userModel(new UserModel(true, this))
-    , m_ipc(new Ipc(this))
     , m_renderWindow(new WOutputRenderWindow(this))
     , m_server(new WServer(this))
     , m_rootContainer(new RootContainer(m_renderWindow->contentItem()))
@@ -52,11 +68,14 @@ Helper::Helper(QObject *parent)
     m_rootContainer->setFlag(QQuickItem::ItemIsFocusScope, true);
 
     connect(m_rootContainer, &RootContainer::primaryOutputChanged, this, [this] () {
-        if (!m_greeter) {
-            m_greeter = qmlEngine()->createGreeter(m_rootContainer->primaryOutput()->outputItem(), this);
-        } else {
-            m_greeter->setParentItem(m_rootContainer->primaryOutput()->outputItem());
-        }
+        // The last output is gone, or a mirror is being promoted.
+        if (!m_rootContainer->primaryOutput())
+            return;
+
+        if (m_greeter)
+            m_greeter->setParentItem(greeterOutput()->outputItem());
+        else if (!m_greeterRequest)
+            createGreeter();
     });
 }
 
@@ -79,9 +98,19 @@ bool Helper::isTestMode() const
 
 bool Helper::login(const QString &user, const QString &password, int sessionId)
 {
-    auto session = m_sessionModel->get(sessionId);
-    Q_ASSERT(session);
-    qDebug() << Q_FUNC_INFO << session->desktopNames() << session->exec();
+    // The models and greetd are only set up after the first frame.
+    if (!m_ipc) {
+        qWarning() << "Not connected to greetd yet!";
+        return false;
+    }
+
+    // A copy, the model may be reloaded while the session starts.
+    const Session session = m_sessionModel->get(sessionId);
+    if (!session.isValid()) {
+        qWarning() << "No session at index" << sessionId;
+        return false;
+    }
+    qDebug() << Q_FUNC_INFO << session.desktopNames() << session.exec();
 
     if (m_sessionIpc) {
         qWarning() << "Another session in progress!";
@@ -97,6 +126,8 @@ bool Helper::login(const QString &user, const QString &password, int sessionId)
         m_sessionIpc = nullptr;
         Q_EMIT sessionSuccess();
         Q_EMIT sessionInProgressChanged();
+        // After the greeter's own handlers ran.
+        QMetaObject::invokeMethod(this, &Helper::exitAfterSession, Qt::QueuedConnection);
     });
 
     connect(m_sessionIpc,
@@ -105,10 +136,15 @@ bool Helper::login(const QString &user, const QString &password, int sessionId)
             [this](const QString &errorType, const QString &description) {
                 qDebug() << "Error" << errorType << description;
                 m_sessionIpc = nullptr;
+                if (std::exchange(m_memoryTrimmed, false)) {
+                    m_sessionModel->load();
+                    m_userModel->load();
+                }
                 Q_EMIT sessionError(errorType, description);
                 Q_EMIT sessionInProgressChanged();
             });
 
+    connect(m_sessionIpc, &SessionIpc::authenticated, this, &Helper::trimMemory);
     connect(m_sessionIpc, &SessionIpc::infoMessage, this, &Helper::infoMessage);
     connect(m_sessionIpc, &SessionIpc::errorMessage, this, &Helper::errorMessage);
 
@@ -118,6 +154,76 @@ bool Helper::login(const QString &user, const QString &password, int sessionId)
     return true;
 }
 
+bool Helper::switchTheme(const QString &theme)
+{
+    if (m_sessionIpc) {
+        qWarning() << "Can't switch theme while a session in progress!";
+        return false;
+    }
+
+    return qmlEngine()->setCurrentTheme(theme);
+}
+
+void Helper::createGreeter()
+{
+    const quint64 request = ++m_greeterRequest;
+    auto output = [this]() -> WOutputItem * {
+        auto o = greeterOutput();
+        return o ? o->outputItem() : nullptr;
+    };
+
+    qmlEngine()->createGreeter(this, output, [this, request](QQuickItem *greeter) {
+        // A theme switch asked for another one meanwhile.
+        if (request != m_greeterRequest) {
+            greeter->deleteLater();
+            return;
+        }
+
+        if (!m_greeter) {
+            m_greeter = greeter;
+            StartupTrace::mark("greeter created");
+            MemoryUsage::checkpoint("greeter");
+            return;
+        }
+
+        // May be called from the old greeter's own JS handler, so defer deletion.
+        m_greeter->deleteLater();
+        m_greeter = greeter;
+        m_greeter->forceActiveFocus();
+    });
+}
+
+void Helper::recreateGreeter()
+{
+    if (!m_greeterRequest || !m_rootContainer->primaryOutput())
+        return;
+
+    // The old greeter stays until the new one is created.
+    createGreeter();
+}
+
+Output *Helper::greeterOutput() const
+{
+    if (m_greeterFollowsCursor) {
+        // Copy outputs are not in the layout, this is always a primary output.
+        if (auto o = m_rootContainer->cursorOutput())
+            return o;
+    }
+
+    return m_rootContainer->primaryOutput();
+}
+
+void Helper::moveGreeterToCursorOutput()
+{
+    if (!m_greeter)
+        return;
+
+    auto o = greeterOutput();
+    // Reparent only, the other outputs just keep their background.
+    if (o && m_greeter->parentItem() != o->outputItem())
+        m_greeter->setParentItem(o->outputItem());
+}
+
 bool Helper::sessionInProgress() const
 {
     return m_sessionIpc;
@@ -143,9 +249,25 @@ WOutputRenderWindow *Helper::window() const
     return m_renderWindow;
 }
 
+RootContainer *Helper::rootContainer() const
+{
+    return m_rootContainer;
+}
+
+QQuickItem *Helper::greeter() const
+{
+    return m_greeter;
+}
+
+IdleManager *Helper::idleManager() const
+{
+    return m_idleManager;
+}
+
 void Helper::init()
 {
     auto engine = qmlEngine();
+    connect(engine, &QmlEngine::currentThemeChanged, this, &Helper::recreateGreeter);
     engine->setContextForObject(m_renderWindow, engine->rootContext());
     engine->setContextForObject(m_renderWindow->contentItem(), engine->rootContext());
     // m_surfaceContainer->setQmlEngine(engine);
@@ -154,6 +276,15 @@ void Helper::init()
     m_seat = m_server->attach<WSeat>();
     m_seat->setEventFilter(this);
     m_seat->setCursor(m_rootContainer->cursor());
+    // Cached, greeterOutput() runs on every cursor move.
+    m_greeterFollowsCursor = WayConfig::instance()->greeterFollowsCursor();
+    if (m_greeterFollowsCursor) {
+        // Also follows the cursor moved off an unplugged output.
+        connect(m_rootContainer->cursor(),
+                &WCursor::positionChanged,
+                this,
+                &Helper::moveGreeterToCursorOutput);
+    }
     m_seat->setKeyboardFocusWindow(m_renderWindow);
 
     m_backend = m_server->attach<WBackend>();
@@ -181,12 +312,126 @@ void Helper::init()
     m_allocator = qw_allocator::autocreate(*m_backend->handle(), *m_renderer);
     m_renderer->init_wl_display(*m_server->handle());
     m_renderWindow->init(m_renderer, m_allocator);
+    if (WayConfig::instance()->damageTracking())
+        m_damageTracker = new DamageTracker(m_renderWindow, m_rootContainer, this);
+    m_idleManager = new IdleManager(m_renderWindow, m_rootContainer, this);
 
     m_backend->handle()->start();
+    StartupTrace::mark("compositor started");
+
+    // Everything not needed to show the greeter waits for its first frame.
+    auto firstFrame = std::make_shared<QMetaObject::Connection>();
+    *firstFrame = connect(m_renderWindow,
+                          &QQuickWindow::afterRendering,
+                          this,
+                          [this, firstFrame, backgroundShown = false]() mutable {
+        if (!std::exchange(backgroundShown, true))
+            StartupTrace::mark("first frame");
+
+        if (!m_greeter)
+            return;
+
+        StartupTrace::mark("first greeter frame");
+        MemoryUsage::checkpoint("first-frame");
+        disconnect(*firstFrame);
+        QMetaObject::invokeMethod(this, &Helper::startServices, Qt::QueuedConnection);
+    });
+}
+
+void Helper::startServices()
+{
+    m_sessionModel->load();
+    StartupTrace::mark("session model");
+    m_userModel->load();
+    StartupTrace::mark("user model");
+    MemoryUsage::checkpoint("models");
+
+    m_ipc = new Ipc(this);
+    qmlEngine()->singletonInstance<PowerManager *>("WayGreet", "PowerManager");
+    StartupTrace::mark("greetd and D-Bus");
+
+    qmlEngine()->preloadThemes(WayConfig::instance()->preloadThemes());
+    StartupTrace::mark("theme preloading started");
+    StartupTrace::finish();
+
+    const bool withinBudget = MemoryUsage::finish();
+    if (MemoryUsage::hasBudget())
+        qApp->exit(withinBudget ? 0 : 1);
+}
+
+void Helper::exitAfterSession()
+{
+    // greetd starts the session once the greeter is gone.
+    if (!WayConfig::instance()->fastExit()) {
+        qInfo() << "Session started, quitting";
+        qApp->quit();
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // The outputs keep their last frame until the session's compositor takes
+    // them over, nothing renders once the event loop isn't running anymore.
+    WayConfig::instance()->sync();
+
+    // CLOCK_MONOTONIC like the journal's, compare it with the session's first
+    // line in `journalctl -o short-monotonic`.
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    qInfo().noquote() << QStringLiteral("Session started, exiting without teardown after %1 us "
+                                        "at monotonic [%2.%3]")
+                             .arg(timer.nsecsElapsed() / 1000)
+                             .arg(now.tv_sec)
+                             .arg(now.tv_nsec / 1000, 6, 10, QLatin1Char('0'));
+    fflush(stdout);
+    fflush(stderr);
+    _exit(0);
+}
+
+void Helper::trimMemory()
+{
+    if (!WayConfig::instance()->trimMemory())
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 before = MemoryUsage::residentBytes();
+
+    // The session to start is a copy held by SessionIpc. With fastExit the
+    // last frame stays on screen until the session takes over, it must still
+    // show the lists.
+    if (!WayConfig::instance()->fastExit()) {
+        m_userModel->clear();
+        m_sessionModel->clear();
+        m_memoryTrimmed = true;
+    }
+
+    // Images shown by the themes stay, they are held by Qt Quick's own pixmap
+    // cache for the frame left on screen. Only the decoded backgrounds kept
+    // for outputs still to come are dropped.
+    if (auto cache = BackgroundCache::instance())
+        cache->clear();
+    const int themes = qmlEngine()->releaseInactiveThemes();
+    qmlEngine()->collectGarbage();
+    qmlEngine()->trimComponentCache();
+    // Glyph caches and other scene graph resources, rebuilt on demand.
+    m_renderWindow->releaseResources();
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+
+    const qint64 after = MemoryUsage::residentBytes();
+    qInfo() << "Trimmed memory in" << timer.elapsed() << "ms, released" << themes
+            << "themes, RSS" << before / 1024 << "KiB ->" << after / 1024 << "KiB";
 }
 
 bool Helper::beforeDisposeEvent(WSeat *seat, QWindow *, QInputEvent *event)
 {
+    // The first input after idle only turns the outputs back on.
+    if (m_idleManager && m_idleManager->notifyActivity())
+        return true;
+
     if (event->type() == QEvent::KeyPress) {
         auto kevent = static_cast<QKeyEvent *>(event);
         if (QKeySequence(kevent->keyCombination()) == QKeySequence::Quit) {
@@ -217,17 +462,25 @@ void Helper::setCursorPosition(const QPointF &position)
     m_seat->setCursorPosition(position);
 }
 
-void Helper::addFakeOutput()
+WOutput *Helper::addFakeOutput()
 {
+    wlr_output *output = nullptr;
     qobject_cast<qw_multi_backend *>(m_backend->handle())
         ->for_each_backend(
-            [](wlr_backend *backend, void *) {
+            [](wlr_backend *backend, void *data) {
+                auto output = static_cast<wlr_output **>(data);
+                if (*output)
+                    return;
                 if (auto x11 = qw_x11_backend::from(backend)) {
-                    qw_output::from(x11->output_create());
+                    *output = x11->output_create();
                 } else if (auto wayland = qw_wayland_backend::from(backend)) {
-                    qw_output::from(wayland->output_create());
+                    *output = wayland->output_create();
+                } else if (auto headless = qw_headless_backend::from(backend)) {
+                    *output = headless->add_output(1920, 1080);
                 }
             },
-            nullptr);
+            &output);
+    // WBackend wraps it from the new_output signal, before it is returned.
+    return output ? WOutput::fromHandle(qw_output::from(output)) : nullptr;
 }
 
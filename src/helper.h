@@ -44,6 +44,8 @@ WAYLIB_SERVER_USE_NAMESPACE
 QW_USE_NAMESPACE
 
 class RootContainer;
+class DamageTracker;
+class IdleManager;
 class Output;
 class Ipc;
 class SessionIpc;
@@ -67,15 +69,23 @@ public:
 
     Q_INVOKABLE bool isTestMode() const;
     Q_INVOKABLE bool login(const QString &user, const QString &password, int sessionId);
+    Q_INVOKABLE bool switchTheme(const QString &theme);
     bool sessionInProgress() const;
 
     SessionModel *sessionModel() const;
     UserModel *userModel() const;
     QmlEngine *qmlEngine() const;
     WOutputRenderWindow *window() const;
+    RootContainer *rootContainer() const;
+    QQuickItem *greeter() const;
+    IdleManager *idleManager() const;
     void init();
 
-    Q_INVOKABLE void addFakeOutput();
+    // Returns the new output, or nullptr if no backend can create one.
+    Q_INVOKABLE WOutput *addFakeOutput();
+    // Once greetd started the session, see WayConfig::fastExit().
+    void exitAfterSession();
+    void setCursorPosition(const QPointF &position);
 
 Q_SIGNALS:
     void primaryOutputChanged();
@@ -87,7 +97,12 @@ Q_SIGNALS:
     void errorMessage(const QString &message);
 
 private:
-    void setCursorPosition(const QPointF &position);
+    void createGreeter();
+    void recreateGreeter();
+    void startServices();
+    void trimMemory();
+    Output *greeterOutput() const;
+    void moveGreeterToCursorOutput();
 
     bool beforeDisposeEvent(WSeat *seat, QWindow *watched, QInputEvent *event) override;
     bool afterHandleEvent(WSeat *seat,
@@ -103,6 +118,8 @@ private:
     UserModel *m_userModel = nullptr;
     Ipc *m_ipc = nullptr;
     SessionIpc *m_sessionIpc = nullptr;
+    // The models were cleared by trimMemory(), reload them if the login fails.
+    bool m_memoryTrimmed = false;
 
     // qtquick helper
     WOutputRenderWindow *m_renderWindow = nullptr;
@@ -116,7 +133,12 @@ private:
 
     // privaet data
     RootContainer *m_rootContainer = nullptr;
+    DamageTracker *m_damageTracker = nullptr;
+    IdleManager *m_idleManager = nullptr;
     QQuickItem *m_greeter = nullptr;
+    // Counts createGreeter() calls, only the latest one's greeter is kept.
+    quint64 m_greeterRequest = 0;
+    bool m_greeterFollowsCursor = false;
 };
 
 Q_DECLARE_OPAQUE_POINTER(RootContainer *)
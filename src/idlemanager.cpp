@@ -0,0 +1,98 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "idlemanager.h"
+
+#include "rootcontainer.h"
+#include "wayconfig.h"
+
+#include <woutputrenderwindow.h>
+
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(qLcIdle, "waygreet.idle")
+
+IdleManager::IdleManager(WOutputRenderWindow *window, RootContainer *container, QObject *parent)
+    : QObject(parent)
+    , m_window(window)
+    , m_container(container)
+{
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &IdleManager::enterIdle);
+
+    // Nothing should be rendered while idle, count it to make that visible.
+    connect(m_window, &QQuickWindow::afterRendering, this, [this] {
+        if (m_idle)
+            ++m_framesWhileIdle;
+    });
+
+    const int timeout = WayConfig::instance()->idleTimeout();
+    if (timeout <= 0)
+        qCInfo(qLcIdle) << "Idle power saving disabled";
+    setTimeout(timeout * 1000);
+}
+
+void IdleManager::setTimeout(int msec)
+{
+    m_timer.setInterval(qMax(0, msec));
+    if (msec > 0)
+        m_timer.start();
+    else
+        m_timer.stop();
+}
+
+bool IdleManager::isIdle() const
+{
+    return m_idle;
+}
+
+int IdleManager::framesWhileIdle() const
+{
+    return m_framesWhileIdle;
+}
+
+bool IdleManager::notifyActivity()
+{
+    if (m_timer.interval() <= 0)
+        return false;
+
+    m_timer.start();
+    if (!m_idle)
+        return false;
+
+    leaveIdle();
+    return true;
+}
+
+void IdleManager::enterIdle()
+{
+    qCInfo(qLcIdle) << "No input for" << m_timer.interval() << "ms, turning outputs off";
+
+    m_idle = true;
+    m_framesWhileIdle = 0;
+    m_idleTimer.start();
+    m_container->setOutputsPowered(false);
+    Q_EMIT idleChanged();
+}
+
+void IdleManager::leaveIdle()
+{
+    qCInfo(qLcIdle) << "Input after" << m_idleTimer.elapsed() / 1000 << "s idle, rendered"
+                    << m_framesWhileIdle << "frames while idle";
+
+    m_idle = false;
+    QElapsedTimer wakeTimer;
+    wakeTimer.start();
+    m_container->setOutputsPowered(true);
+
+    connect(
+        m_window,
+        &QQuickWindow::afterRendering,
+        this,
+        [wakeTimer] {
+            qCInfo(qLcIdle) << "First frame after wake up in" << wakeTimer.elapsed() << "ms";
+        },
+        Qt::SingleShotConnection);
+
+    Q_EMIT idleChanged();
+}
@@ -0,0 +1,55 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <wglobal.h>
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+WAYLIB_SERVER_BEGIN_NAMESPACE
+class WOutputRenderWindow;
+WAYLIB_SERVER_END_NAMESPACE
+
+WAYLIB_SERVER_USE_NAMESPACE
+
+class RootContainer;
+
+// Turns the outputs off and stops rendering after WayConfig::idleTimeout()
+// seconds without input, any input turns them back on.
+class IdleManager : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool idle READ isIdle NOTIFY idleChanged FINAL)
+
+public:
+    explicit IdleManager(WOutputRenderWindow *window,
+                         RootContainer *container,
+                         QObject *parent = nullptr);
+
+    bool isIdle() const;
+    // Milliseconds without input, 0 disables it. Initially idleTimeout().
+    void setTimeout(int msec);
+    // Since the outputs were last turned off, expected to stay 0.
+    int framesWhileIdle() const;
+
+    // Call for every input event, returns true if the event only woke the
+    // outputs up and should not reach the greeter.
+    bool notifyActivity();
+
+Q_SIGNALS:
+    void idleChanged();
+
+private:
+    void enterIdle();
+    void leaveIdle();
+
+    WOutputRenderWindow *m_window;
+    RootContainer *m_container;
+    QTimer m_timer;
+    QElapsedTimer m_idleTimer;
+    bool m_idle = false;
+    int m_framesWhileIdle = 0;
+};
@@ -5,6 +5,7 @@
 
 #include <QDebug>
 #include <QJsonDocument>
+#include <QJsonObject>
 #include <QLocalSocket>
 
 // IpcReply
@@ -15,46 +16,45 @@ IpcReply::IpcReply(QObject *parent)
 
 QString IpcReply::type() const
 {
-    return m_reply.value(QStringLiteral("type")).toString();
+    return m_reply.type;
 }
 
 QString IpcReply::requestType() const
 {
-    return m_request.value(QStringLiteral("type")).toString();
+    return m_requestType;
 }
 
 QString IpcReply::errorType() const
 {
-    return m_reply.value(QStringLiteral("error_type")).toString();
+    return m_reply.errorType;
 }
 
 QString IpcReply::errorDescription() const
 {
-    return m_reply.value(QStringLiteral("description")).toString();
+    return m_reply.description;
 }
 
 QString IpcReply::authMessageType() const
 {
-    return m_reply.value(QStringLiteral("auth_message_type")).toString();
+    return m_reply.authMessageType;
 }
 
 QString IpcReply::authMessage() const
 {
-    return m_reply.value(QStringLiteral("auth_message")).toString();
+    return m_reply.authMessage;
 }
 
-// Ipc
-Ipc::Ipc(QObject *parent)
+// IpcWorker
+IpcWorker::IpcWorker(QObject *parent)
     : QObject(parent)
 {
-    const QString greetdSock = qEnvironmentVariable("GREETD_SOCK");
-    if (greetdSock.isEmpty()) {
-        qCritical() << "GREETD_SOCK not set";
-        return;
-    }
+}
+
+void IpcWorker::connectToServer(const QString &path)
+{
+    Q_ASSERT(thread() == QThread::currentThread());
 
     m_socket = new QLocalSocket(this);
-    m_socket->connectToServer(greetdSock);
 
     connect(m_socket, &QLocalSocket::connected, this, [this]() {
         qInfo() << "Socket connected";
@@ -71,7 +71,78 @@ Ipc::Ipc(QObject *parent)
                 qWarning() << "Socket error" << socketError;
             });
 
-    connect(m_socket, &QLocalSocket::readyRead, this, &Ipc::readyRead);
+    connect(m_socket, &QLocalSocket::readyRead, this, &IpcWorker::readyRead);
+
+    m_socket->connectToServer(path);
+}
+
+void IpcWorker::sendRequest(const QVariantMap &request)
+{
+    QByteArray data(QJsonDocument::fromVariant(request).toJson(QJsonDocument::Compact));
+    const qint32 size = data.size();
+    data.prepend(4, 0);
+    memcpy(data.data(), &size, sizeof(size));
+    m_socket->write(data);
+    // Don't wait for the event loop to get it out.
+    m_socket->flush();
+}
+
+void IpcWorker::readyRead()
+{
+    // Several replies may arrive in one read.
+    while (true) {
+        if (m_length == -1) {
+            if (m_socket->bytesAvailable() < 4) {
+                return;
+            }
+            m_socket->read(reinterpret_cast<char *>(&m_length), 4);
+        }
+
+        if (m_socket->bytesAvailable() < m_length) {
+            return;
+        }
+
+        const QByteArray payload = m_socket->read(m_length);
+        m_length = -1;
+
+        const QJsonObject object = QJsonDocument::fromJson(payload).object();
+        GreetdReply reply;
+        reply.type = object.value(QStringLiteral("type")).toString();
+        reply.errorType = object.value(QStringLiteral("error_type")).toString();
+        reply.description = object.value(QStringLiteral("description")).toString();
+        reply.authMessageType = object.value(QStringLiteral("auth_message_type")).toString();
+        reply.authMessage = object.value(QStringLiteral("auth_message")).toString();
+        Q_EMIT replyReceived(reply);
+    }
+}
+
+// Ipc
+Ipc::Ipc(QObject *parent)
+    : QObject(parent)
+{
+    const QString greetdSock = qEnvironmentVariable("GREETD_SOCK");
+    if (greetdSock.isEmpty()) {
+        qCritical() << "GREETD_SOCK not set";
+        return;
+    }
+
+    m_thread.setObjectName(QStringLiteral("greetd ipc"));
+    m_worker = new IpcWorker;
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    // Queued, m_worker lives on m_thread.
+    connect(m_worker, &IpcWorker::replyReceived, this, &Ipc::replyReceived);
+    m_thread.start();
+
+    QMetaObject::invokeMethod(m_worker, [worker = m_worker, greetdSock] {
+        worker->connectToServer(greetdSock);
+    });
+}
+
+Ipc::~Ipc()
+{
+    m_thread.quit();
+    m_thread.wait();
 }
 
 IpcReply *Ipc::createSession(const QString &username)
@@ -113,31 +184,17 @@ IpcReply *Ipc::sendRequest(const QVariantMap &m)
 {
     Q_ASSERT(!m_reply);
     m_reply = new IpcReply(this);
-    m_reply->m_request = m;
-    QByteArray data(QJsonDocument::fromVariant(m).toJson(QJsonDocument::Compact));
-    const qint32 size = data.size();
-    data.prepend(4, 0);
-    memcpy(data.data(), &size, sizeof(size));
-    m_socket->write(data);
+    m_reply->m_requestType = m.value(QStringLiteral("type")).toString();
+    if (m_worker) {
+        QMetaObject::invokeMethod(m_worker, [worker = m_worker, m] {
+            worker->sendRequest(m);
+        });
+    }
     return m_reply;
 }
 
-void Ipc::readyRead()
+void Ipc::replyReceived(const GreetdReply &payload)
 {
-    if (m_length == -1) {
-        if (m_socket->bytesAvailable() < 4) {
-            return;
-        }
-        m_socket->read(reinterpret_cast<char *>(&m_length), 4);
-    }
-
-    if (m_socket->bytesAvailable() < m_length) {
-        return;
-    }
-
-    const QByteArray payload = m_socket->read(m_length);
-    m_length = -1;
-
     if (!m_reply) {
         qCritical() << "Received reply without sending request!";
         return;
@@ -146,7 +203,7 @@ void Ipc::readyRead()
     IpcReply *reply = m_reply;
     m_reply = nullptr;
 
-    reply->m_reply = QJsonDocument::fromJson(payload).toVariant().toMap();
+    reply->m_reply = payload;
     reply->deleteLater();
     Q_EMIT reply->finished(reply);
 }
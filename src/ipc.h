@@ -6,10 +6,22 @@
 #pragma once
 
 #include <QObject>
+#include <QThread>
 #include <QVariantMap>
 
 class QLocalSocket;
 
+// A greetd reply, decoded on the IPC thread. Fields greetd didn't send are empty.
+struct GreetdReply
+{
+    QString type;
+    QString errorType;
+    QString description;
+    QString authMessageType;
+    QString authMessage;
+};
+Q_DECLARE_METATYPE(GreetdReply)
+
 class IpcReply : public QObject
 {
     Q_OBJECT
@@ -30,18 +42,44 @@ Q_SIGNALS:
 private:
     explicit IpcReply(QObject *parent = nullptr);
 
-    QVariantMap m_reply;
-    QVariantMap m_request;
+    GreetdReply m_reply;
+    QString m_requestType;
 
     friend class Ipc;
 };
 
+// Owns the greetd socket on Ipc's thread. Requests are framed and written
+// there, replies are read and decoded there, and the decoded reply is posted
+// back to the GUI thread, so rendering doesn't delay reading it. The next
+// request is still sent from the GUI thread's handler of that reply, so it
+// waits behind a stalled frame.
+class IpcWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit IpcWorker(QObject *parent = nullptr);
+
+    void connectToServer(const QString &path);
+    void sendRequest(const QVariantMap &request);
+
+Q_SIGNALS:
+    void replyReceived(const GreetdReply &reply);
+
+private:
+    void readyRead();
+
+    QLocalSocket *m_socket = nullptr;
+    qint32 m_length = -1;
+};
+
 class Ipc : public QObject
 {
     Q_OBJECT
 
 public:
     explicit Ipc(QObject *parent = nullptr);
+    ~Ipc() override;
 
     IpcReply *createSession(const QString &username);
     IpcReply *postAuthMessageResponse(const QString &response = QString());
@@ -49,10 +87,10 @@ public:
     IpcReply *cancelSession();
 
 private:
-    void readyRead();
+    void replyReceived(const GreetdReply &reply);
     IpcReply *sendRequest(const QVariantMap &m);
 
-    QLocalSocket *m_socket = nullptr;
-    qint32 m_length = -1;
+    QThread m_thread;
+    IpcWorker *m_worker = nullptr;
     IpcReply *m_reply = nullptr;
 };
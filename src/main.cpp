@@ -1,10 +1,15 @@
 // Copyright (C) 2025 rewine <luhongxu@deepin.org>.
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include "backgroundcache.h"
+#include "benchmark.h"
 #include "helper.h"
+#include "memoryusage.h"
 #include "wayconfig.h"
-#include "powermanager.h"
+#include "startuptrace.h"
+#include "zygote.h"
 
+#include <woutputrenderwindow.h>
 #include <wrenderhelper.h>
 
 #include <qwbuffer.h>
@@ -12,13 +17,57 @@
 
 #include <QGuiApplication>
 #include <QCommandLineParser>
+#include <QElapsedTimer>
+
+#include <cstring>
 
 WAYLIB_SERVER_USE_NAMESPACE
 
+// Also matches "--name=value", which QCommandLineParser accepts as well.
+static bool isOption(const char *arg, const char *name)
+{
+    const size_t length = strlen(name);
+    return strncmp(arg, name, length) == 0 && (arg[length] == '\0' || arg[length] == '=');
+}
+
+// The value of `name` at argv[i], given as "--name value" or "--name=value".
+static const char *optionValue(int argc, char *argv[], int i, const char *name)
+{
+    if (!isOption(argv[i], name))
+        return nullptr;
+    const char *value = argv[i] + strlen(name);
+    if (*value == '=')
+        return value + 1;
+    return i + 1 < argc ? argv[i + 1] : nullptr;
+}
+
 int main(int argc, char *argv[])
 {
+    // Before anything else, greeters forked by the zygote start from here.
+    for (int i = 1; i < argc; ++i) {
+        int exitCode = 0;
+        const char *zygote = optionValue(argc, argv, i, "--zygote");
+        if (zygote && !Zygote::serve(zygote, &exitCode))
+            return exitCode;
+        const char *connect = optionValue(argc, argv, i, "--zygote-connect");
+        if (connect && Zygote::connect(connect, &exitCode))
+            return exitCode;
+    }
+
+    StartupTrace::mark("main");
     qw_log::init(WLR_ERROR);
 
+    // The backend and renderer are picked before QCommandLineParser is usable.
+    for (int i = 1; i < argc; ++i) {
+        if (isOption(argv[i], "--benchmark-frames") || isOption(argv[i], "--benchmark-hotplug")
+            || isOption(argv[i], "--benchmark-idle") || isOption(argv[i], "--benchmark-exit")
+            || isOption(argv[i], "--memory-budget"))
+            ThemeBenchmark::setupHeadlessBackend();
+        // Early enough to include Qt's own startup.
+        if (isOption(argv[i], "--memory-trace") || isOption(argv[i], "--memory-budget"))
+            MemoryUsage::countAllocations();
+    }
+
     WRenderHelper::setupRendererBackend();
     Q_ASSERT(qw_buffer::get_objects().isEmpty());
 
@@ -26,12 +75,16 @@ int main(int argc, char *argv[])
 
     QPointer<Helper> helper;
     int quitCode = 0;
+    QElapsedTimer exitTimer;
     {
         QGuiApplication::setAttribute(Qt::AA_UseOpenGLES);
         QGuiApplication::setHighDpiScaleFactorRoundingPolicy(
             Qt::HighDpiScaleFactorRoundingPolicy::PassThrough);
         QGuiApplication::setQuitOnLastWindowClosed(false);
         QGuiApplication app(argc, argv);
+        StartupTrace::mark("application");
+        // The platform plugin is loaded by the constructor.
+        MemoryUsage::checkpoint("qpa");
 
         QCommandLineParser parser;
         parser.setApplicationDescription("Simple Greeter for greetd");
@@ -41,9 +94,77 @@ int main(int argc, char *argv[])
         QCommandLineOption themeOption(QStringList() << "t" << "theme", "Theme name or directory to use", "theme");
         parser.addOption(themeOption);
 
+        QCommandLineOption benchmarkOption("benchmark-frames",
+                                           "Render the theme on a headless output for <frames> "
+                                           "frames, print timings and quit",
+                                           "frames");
+        parser.addOption(benchmarkOption);
+
+        QCommandLineOption hotplugBenchmarkOption("benchmark-hotplug",
+                                                  "Plug headless outputs in and out <cycles> "
+                                                  "times per output mode, print timings and "
+                                                  "quit, non-zero on failed checks",
+                                                  "cycles");
+        parser.addOption(hotplugBenchmarkOption);
+
+        QCommandLineOption idleBenchmarkOption("benchmark-idle",
+                                               "Let the headless output go idle for <seconds>, "
+                                               "quit non-zero if a frame is rendered meanwhile",
+                                               "seconds");
+        parser.addOption(idleBenchmarkOption);
+
+        QCommandLineOption exitBenchmarkOption("benchmark-exit",
+                                               "Start on a headless output and exit as after a "
+                                               "started session once the greeter is shown, print "
+                                               "how long exiting took");
+        parser.addOption(exitBenchmarkOption);
+
+        QCommandLineOption sessionBenchmarkOption("benchmark-sessions",
+                                                  "Load <sessions> generated session files, "
+                                                  "print timings of the session model and quit",
+                                                  "sessions");
+        parser.addOption(sessionBenchmarkOption);
+
+        QCommandLineOption startupTraceOption("startup-trace",
+                                              "Print the time taken by each startup stage");
+        parser.addOption(startupTraceOption);
+
+        QCommandLineOption memoryTraceOption("memory-trace",
+                                             "Print RSS, heap and allocations at each startup "
+                                             "checkpoint");
+        parser.addOption(memoryTraceOption);
+
+        QCommandLineOption memoryBudgetOption("memory-budget",
+                                              "Start on a headless output, quit once started, "
+                                              "non-zero if a checkpoint's RSS exceeds its KiB "
+                                              "in <budget>, e.g. greeter=150000,models=180000",
+                                              "budget");
+        parser.addOption(memoryBudgetOption);
+
+        // Handled before the application exists, see zygote.h.
+        QCommandLineOption zygoteOption("zygote",
+                                        "Keep caches warm and fork a greeter for each "
+                                        "--zygote-connect on <socket>",
+                                        "socket");
+        parser.addOption(zygoteOption);
+        QCommandLineOption zygoteConnectOption("zygote-connect",
+                                               "Let the zygote on <socket> fork the greeter, "
+                                               "start normally if there is none",
+                                               "socket");
+        parser.addOption(zygoteConnectOption);
+
         parser.process(app);
 
+        StartupTrace::setEnabled(parser.isSet(startupTraceOption));
+        MemoryUsage::setTraceEnabled(parser.isSet(memoryTraceOption));
+        if (parser.isSet(memoryBudgetOption)
+            && !MemoryUsage::setBudget(parser.value(memoryBudgetOption))) {
+            qCritical() << "Invalid memory budget" << parser.value(memoryBudgetOption);
+            return 1;
+        }
+
         QmlEngine qmlEngine;
+        StartupTrace::mark("qml engine");
 
         QObject::connect(&qmlEngine, &QQmlEngine::quit, &app, &QGuiApplication::quit);
         QObject::connect(&qmlEngine, &QQmlEngine::exit, &app, [](int code) {
@@ -57,15 +178,58 @@ int main(int argc, char *argv[])
             config->setThemeOverride(parser.value(themeOption));
         }
 
+        // Only needs the configuration, no compositor.
+        if (parser.isSet(sessionBenchmarkOption))
+            return SessionBenchmark::run(parser.value(sessionBenchmarkOption).toInt());
+
+        // Used from the image provider before any QML may have touched it.
+        qmlEngine.singletonInstance<BackgroundCache *>("WayGreet", "BackgroundCache");
+
         auto helper = qmlEngine.singletonInstance<Helper *>("WayGreet", "Helper");
         helper->init();
+        MemoryUsage::checkpoint("helper");
+
+        if (parser.isSet(benchmarkOption)) {
+            auto benchmark = new ThemeBenchmark(helper, parser.value(benchmarkOption).toInt(), &app);
+            benchmark->start();
+        } else if (parser.isSet(hotplugBenchmarkOption)) {
+            auto benchmark =
+                new HotplugBenchmark(helper, parser.value(hotplugBenchmarkOption).toInt(), &app);
+            benchmark->start();
+        } else if (parser.isSet(idleBenchmarkOption)) {
+            auto benchmark =
+                new IdleBenchmark(helper, parser.value(idleBenchmarkOption).toInt(), &app);
+            benchmark->start();
+        } else if (parser.isSet(exitBenchmarkOption)) {
+            helper->addFakeOutput();
+            QObject::connect(helper->window(),
+                             &QQuickWindow::afterRendering,
+                             helper,
+                             [helper, &exitTimer] {
+                                 if (!helper->greeter() || exitTimer.isValid())
+                                     return;
+                                 exitTimer.start();
+                                 // Queued like after start_session, not inside the frame.
+                                 QMetaObject::invokeMethod(helper,
+                                                           &Helper::exitAfterSession,
+                                                           Qt::QueuedConnection);
+                             });
+        } else if (MemoryUsage::hasBudget()) {
+            // The headless backend has no outputs, the greeter needs one.
+            helper->addFakeOutput();
+        }
 
-        auto powermanager = qmlEngine.singletonInstance<PowerManager *>("WayGreet", "PowerManager");
-        Q_ASSERT(powermanager);
+        // Without WayConfig::fastExit(), measures the teardown greetd waits for.
+        QObject::connect(helper, &Helper::sessionSuccess, &app, [&exitTimer] {
+            exitTimer.start();
+        });
 
         quitCode = app.exec();
     }
 
+    if (exitTimer.isValid())
+        qInfo() << "Exited" << exitTimer.elapsed() << "ms after the session started";
+
     Q_ASSERT(!helper);
     Q_ASSERT(qw_buffer::get_objects().isEmpty());
 
@@ -0,0 +1,213 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "memoryusage.h"
+
+#include <QHash>
+#include <QList>
+#include <QLoggingCategory>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include <unistd.h>
+
+Q_LOGGING_CATEGORY(qLcMemory, "waygreet.memory")
+
+namespace {
+std::atomic<bool> s_counting{ false };
+std::atomic<quint64> s_allocations{ 0 };
+
+inline void countAllocation()
+{
+    if (s_counting.load(std::memory_order_relaxed))
+        s_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+} // namespace
+
+// Counts C++ allocations of the process, Qt's included, once countAllocations()
+// was called. Other forms of new, e.g. new[] and the nothrow ones, end up here
+// in libstdc++ and libc++. The matching deletes are replaced too, so every
+// pointer from here is freed with free().
+void *operator new(std::size_t size)
+{
+    countAllocation();
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    countAllocation();
+    // aligned_alloc needs a multiple of the alignment.
+    const auto align = static_cast<std::size_t>(alignment);
+    const std::size_t rounded = (qMax<std::size_t>(size, 1) + align - 1) & ~(align - 1);
+    if (void *p = std::aligned_alloc(align, rounded))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+namespace MemoryUsage {
+
+namespace {
+struct Checkpoint
+{
+    QString name;
+    qint64 resident;
+    qint64 heap;
+    quint64 allocations;
+};
+
+bool s_enabled = false;
+bool s_finished = false;
+QList<Checkpoint> s_checkpoints;
+QHash<QString, qint64> s_budget;
+} // namespace
+
+qint64 residentBytes()
+{
+    // Read with stdio, this is called while measuring Qt's own allocations.
+    FILE *file = std::fopen("/proc/self/statm", "r");
+    if (!file)
+        return -1;
+
+    long size = 0;
+    long resident = 0;
+    const int n = std::fscanf(file, "%ld %ld", &size, &resident);
+    std::fclose(file);
+    if (n != 2)
+        return -1;
+
+    return qint64(resident) * sysconf(_SC_PAGESIZE);
+}
+
+qint64 heapBytes()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    const struct mallinfo2 info = mallinfo2();
+    // Both the main arena and the chunks too big for it.
+    return qint64(info.uordblks + info.hblkhd);
+#else
+    return -1;
+#endif
+}
+
+quint64 allocationCount()
+{
+    return s_allocations.load(std::memory_order_relaxed);
+}
+
+void countAllocations()
+{
+    s_counting.store(true, std::memory_order_relaxed);
+}
+
+void setTraceEnabled(bool enabled)
+{
+    s_enabled = enabled;
+}
+
+void checkpoint(const QString &name)
+{
+    if (s_finished)
+        return;
+
+    const Checkpoint checkpoint{ name, residentBytes(), heapBytes(), allocationCount() };
+    s_checkpoints.append(checkpoint);
+    qCDebug(qLcMemory).noquote() << name << "RSS" << checkpoint.resident / 1024 << "KiB heap"
+                                 << checkpoint.heap / 1024 << "KiB" << checkpoint.allocations
+                                 << "allocations";
+}
+
+bool setBudget(const QString &spec)
+{
+    s_budget.clear();
+    for (const auto &entry : spec.split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+        const auto parts = entry.split(QLatin1Char('='));
+        bool ok = false;
+        const qint64 kib = parts.size() == 2 ? parts.at(1).trimmed().toLongLong(&ok) : 0;
+        if (!ok || kib <= 0)
+            return false;
+        s_budget.insert(parts.at(0).trimmed(), kib);
+    }
+    return !s_budget.isEmpty();
+}
+
+bool hasBudget()
+{
+    return !s_budget.isEmpty();
+}
+
+bool finish()
+{
+    if (s_finished)
+        return true;
+    s_finished = true;
+
+    bool withinBudget = true;
+    const Checkpoint *previous = nullptr;
+    for (const auto &checkpoint : std::as_const(s_checkpoints)) {
+        const qint64 budget = s_budget.value(checkpoint.name, -1);
+        const bool exceeded = budget >= 0 && checkpoint.resident / 1024 > budget;
+        withinBudget = withinBudget && !exceeded;
+
+        if (s_enabled || exceeded) {
+            const qint64 rssDelta = previous ? checkpoint.resident - previous->resident : 0;
+            const quint64 allocationDelta =
+                previous ? checkpoint.allocations - previous->allocations : 0;
+            qCInfo(qLcMemory).noquote()
+                << QStringLiteral("RSS %1 KiB (+%2) heap %3 KiB allocations %4 (+%5) %6%7")
+                       .arg(checkpoint.resident / 1024, 7)
+                       .arg(rssDelta / 1024, 6)
+                       .arg(checkpoint.heap / 1024, 7)
+                       .arg(checkpoint.allocations, 9)
+                       .arg(allocationDelta, 8)
+                       .arg(checkpoint.name)
+                       .arg(exceeded ? QStringLiteral(" over budget of %1 KiB").arg(budget)
+                                     : QString());
+        }
+        previous = &checkpoint;
+    }
+
+    for (auto it = s_budget.cbegin(); it != s_budget.cend(); ++it) {
+        const bool reached = std::any_of(s_checkpoints.cbegin(),
+                                         s_checkpoints.cend(),
+                                         [&it](const Checkpoint &c) { return c.name == it.key(); });
+        if (!reached) {
+            qCWarning(qLcMemory) << "Budget for unknown checkpoint" << it.key();
+            withinBudget = false;
+        }
+    }
+
+    s_checkpoints.clear();
+    return withinBudget;
+}
+
+} // namespace MemoryUsage
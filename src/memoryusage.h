@@ -0,0 +1,34 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <QString>
+
+namespace MemoryUsage {
+
+// Resident set size of the process in bytes, -1 if it can't be read.
+qint64 residentBytes();
+// Bytes allocated from the malloc heap, -1 if the libc can't tell.
+qint64 heapBytes();
+// Calls of the global operator new since countAllocations(). Only C++
+// allocations are seen, malloc() from C libraries like wlroots and Mesa
+// shows up in heapBytes() only.
+quint64 allocationCount();
+// Off by default, operator new then costs a single relaxed load more.
+void countAllocations();
+
+// Records RSS, heap and allocations at a startup stage, printed by finish()
+// with `waygreet --memory-trace`, logged to waygreet.memory at debug level
+// otherwise.
+void setTraceEnabled(bool enabled);
+void checkpoint(const QString &name);
+
+// Maximum RSS of checkpoints in KiB, e.g. "greeter=150000,models=180000".
+// Returns false if spec can't be parsed.
+bool setBudget(const QString &spec);
+bool hasBudget();
+// Returns false if a checkpoint exceeded its budget.
+bool finish();
+
+} // namespace MemoryUsage
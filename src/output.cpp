@@ -3,24 +3,50 @@
 
 #include "output.h"
 
+#include "framestats.h"
 #include "helper.h"
+#include "qmlengine.h"
 #include "rootcontainer.h"
+#include "wayconfig.h"
 
 #include <woutputitem.h>
 #include <woutputlayout.h>
 #include <woutputrenderwindow.h>
 #include <wquicktextureproxy.h>
 
+#include <qwoutput.h>
 #include <qwoutputlayout.h>
 
 #include <QQmlEngine>
 
-Output *Output::createPrimary(WOutput *output, QQmlEngine *engine, QObject *parent)
+QVariantMap Output::primaryProperties(WOutput *output)
+{
+    return { { "forceSoftwareCursor", output->handle()->is_x11() } };
+}
+
+QVariantMap Output::copyProperties(Output *proxy)
+{
+    return { { "targetOutputItem", QVariant::fromValue(proxy->outputItem()) } };
+}
+
+Output *Output::createPrimary(WOutput *output, QmlEngine *engine, QObject *parent)
+{
+    auto component = engine->primaryOutputComponent();
+    QObject *obj = component->beginCreate(engine->rootContext());
+    component->setInitialProperties(obj, primaryProperties(output));
+    component->completeCreate();
+    return fromPrimaryItem(output, obj, parent);
+}
+
+Output *Output::createCopy(WOutput *output, Output *proxy, QmlEngine *engine, QObject *parent)
+{
+    QObject *obj = engine->copyOutputComponent()->createWithInitialProperties(copyProperties(proxy),
+                                                                              engine->rootContext());
+    return fromCopyItem(output, proxy, obj, parent);
+}
+
+Output *Output::fromPrimaryItem(WOutput *output, QObject *obj, QObject *parent)
 {
-    QQmlComponent delegate(engine, "WayGreet", "PrimaryOutput");
-    QObject *obj = delegate.beginCreate(engine->rootContext());
-    delegate.setInitialProperties(obj, { { "forceSoftwareCursor", output->handle()->is_x11() } });
-    delegate.completeCreate();
     WOutputItem *outputItem = qobject_cast<WOutputItem *>(obj);
     Q_ASSERT(outputItem);
     QQmlEngine::setObjectOwnership(outputItem, QQmlEngine::CppOwnership);
@@ -32,24 +58,21 @@ Output *Output::createPrimary(WOutput *output, QQmlEngine *engine, QObject *pare
 
     auto contentItem = Helper::instance()->window()->contentItem();
     outputItem->setParentItem(contentItem);
+    o->m_stats = new FrameStats(output, o->renderViewport(), Helper::instance()->window(), o);
 
 #ifdef QT_DEBUG
-    o->m_menuBar = Helper::instance()->qmlEngine()->createMenuBar(outputItem, contentItem);
+    o->m_menuBar =
+        Helper::instance()->qmlEngine()->createMenuBar(outputItem, o->m_stats, contentItem);
     o->m_menuBar->setZ(999);
 #endif
 
     return o;
 }
 
-Output *Output::createCopy(WOutput *output, Output *proxy, QQmlEngine *engine, QObject *parent)
+Output *Output::fromCopyItem(WOutput *output, Output *proxy, QObject *obj, QObject *parent)
 {
-    QQmlComponent delegate(engine, "WayGreet", "CopyOutput");
-    QObject *obj = delegate.createWithInitialProperties(
-        {
-            { "targetOutputItem", QVariant::fromValue(proxy->outputItem()) },
-        },
-        engine->rootContext());
-
+    // The item may have been created for another proxy.
+    obj->setProperty("targetOutputItem", QVariant::fromValue(proxy->outputItem()));
     WOutputItem *outputItem = qobject_cast<WOutputItem *>(obj);
     Q_ASSERT(outputItem);
     QQmlEngine::setObjectOwnership(outputItem, QQmlEngine::CppOwnership);
@@ -62,11 +85,8 @@ Output *Output::createCopy(WOutput *output, Output *proxy, QQmlEngine *engine, Q
 
     auto contentItem = Helper::instance()->window()->contentItem();
     outputItem->setParentItem(contentItem);
-    o->updatePrimaryOutputHardwareLayers();
-    connect(o->m_outputViewport,
-            &WOutputViewport::hardwareLayersChanged,
-            o,
-            &Output::updatePrimaryOutputHardwareLayers);
+    o->m_stats = new FrameStats(output, o->renderViewport(), Helper::instance()->window(), o);
+    o->setProxyAttached(true);
 
     return o;
 }
@@ -75,11 +95,22 @@ Output::Output(WOutputItem *output, QObject *parent)
     : QObject(parent)
     , m_item(output)
 {
+    ++m_liveCount;
     m_outputViewport = output->property("screenViewport").value<WOutputViewport *>();
+
+    output->output()->handle()->safeConnect(&qw_output::notify_commit,
+                                            this,
+                                            [this](wlr_output_event_commit *event) {
+                                                if (event->state->committed
+                                                    & WLR_OUTPUT_STATE_BUFFER)
+                                                    m_hasFrame = true;
+                                            });
 }
 
 Output::~Output()
 {
+    --m_liveCount;
+
     if (m_menuBar) {
         delete m_menuBar;
         m_menuBar = nullptr;
@@ -91,11 +122,64 @@ Output::~Output()
     }
 }
 
+int Output::liveCount()
+{
+    return m_liveCount;
+}
+
 bool Output::isPrimary() const
 {
     return m_type == Type::Primary;
 }
 
+Output *Output::proxy() const
+{
+    return m_proxy;
+}
+
+void Output::setProxy(Output *proxy)
+{
+    Q_ASSERT(!isPrimary() && proxy && proxy->isPrimary());
+    if (m_proxy == proxy)
+        return;
+
+    if (m_active)
+        setProxyAttached(false);
+
+    m_proxy = proxy;
+    m_item->setProperty("targetOutputItem", QVariant::fromValue(proxy->outputItem()));
+    m_outputViewport = proxy->screenViewport();
+
+    if (m_active)
+        setProxyAttached(true);
+}
+
+bool Output::isActive() const
+{
+    return m_active;
+}
+
+void Output::setActive(bool active)
+{
+    if (m_active == active)
+        return;
+
+    m_active = active;
+    // Waits for a new frame, like a newly created output.
+    m_hasFrame = false;
+    if (!isPrimary())
+        setProxyAttached(active);
+
+    m_item->setProperty("active", active);
+    if (m_menuBar)
+        m_menuBar->setVisible(active);
+}
+
+bool Output::hasFrame() const
+{
+    return m_hasFrame;
+}
+
 WOutput *Output::output() const
 {
     auto o = m_item->output();
@@ -129,6 +213,90 @@ std::pair<WOutputViewport *, QQuickItem *> Output::getOutputItemProperty()
     return std::make_pair(viewportCopy, textureProxy);
 }
 
+void Output::setProxyAttached(bool attached)
+{
+    disconnect(m_hardwareLayersConnection);
+    disconnect(m_proxyCommitConnection);
+    if (attached) {
+        updatePrimaryOutputHardwareLayers();
+        m_hardwareLayersConnection = connect(m_outputViewport,
+                                             &WOutputViewport::hardwareLayersChanged,
+                                             this,
+                                             &Output::updatePrimaryOutputHardwareLayers);
+        if (WayConfig::instance()->directScanoutMirror())
+            m_proxyCommitConnection =
+                m_proxy->output()->handle()->safeConnect(&qw_output::notify_commit,
+                                                         this,
+                                                         &Output::onProxyCommit);
+        return;
+    }
+
+    setDirectScanout(false);
+    auto viewportCopy = getOutputItemProperty().first;
+    for (auto layer : std::as_const(m_hardwareLayersOfPrimaryOutput))
+        Helper::instance()->window()->detach(layer, viewportCopy);
+    m_hardwareLayersOfPrimaryOutput.clear();
+}
+
+bool Output::isDirectScanout() const
+{
+    return m_directScanout;
+}
+
+bool Output::canScanoutFrom(Output *source) const
+{
+    // Hardware layers, e.g. the cursor, are not part of the buffer.
+    if (!source->screenViewport()->hardwareLayers().isEmpty())
+        return false;
+
+    // Otherwise the mirror has to be scaled or rotated, keep the proxy path.
+    auto src = source->output()->nativeHandle();
+    auto dst = output()->nativeHandle();
+    return src->width == dst->width && src->height == dst->height
+        && src->transform == dst->transform;
+}
+
+void Output::onProxyCommit(wlr_output_event_commit *event)
+{
+    if (!(event->state->committed & WLR_OUTPUT_STATE_BUFFER) || !event->state->buffer)
+        return;
+
+    if (!canScanoutFrom(m_proxy)) {
+        setDirectScanout(false);
+        return;
+    }
+
+    // The mirror's previous page flip hasn't completed, committing now would
+    // fail or be dropped. Compose this frame, the next one tries again.
+    auto handle = output()->nativeHandle();
+    if (!handle->enabled || handle->frame_pending) {
+        setDirectScanout(false);
+        return;
+    }
+
+    qw_output_state newState;
+    newState.set_buffer(event->state->buffer);
+    auto qwoutput = output()->handle();
+    // E.g. another GPU can't import the buffer.
+    if (!qwoutput->test_state(newState) || !qwoutput->commit_state(newState)) {
+        setDirectScanout(false);
+        return;
+    }
+
+    setDirectScanout(true);
+    m_stats->addDirectScanoutFrame();
+}
+
+void Output::setDirectScanout(bool directScanout)
+{
+    if (m_directScanout == directScanout)
+        return;
+
+    m_directScanout = directScanout;
+    // Back to composing, render the mirror at once instead of on next damage.
+    renderViewport()->setLive(!directScanout);
+}
+
 void Output::updatePrimaryOutputHardwareLayers()
 {
     WOutputViewport *viewportPrimary = screenViewport();
@@ -164,3 +332,16 @@ WOutputViewport *Output::screenViewport() const
 {
     return m_outputViewport;
 }
+
+WOutputViewport *Output::renderViewport() const
+{
+    if (isPrimary())
+        return m_outputViewport;
+
+    return m_item->findChild<WOutputViewport *>({}, Qt::FindDirectChildrenOnly);
+}
+
+FrameStats *Output::stats() const
+{
+    return m_stats;
+}
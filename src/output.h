@@ -10,7 +10,10 @@
 #include <QObject>
 #include <QQmlComponent>
 
+struct wlr_output_event_commit;
+
 Q_MOC_INCLUDE(<woutputitem.h>)
+Q_MOC_INCLUDE("framestats.h")
 
 WAYLIB_SERVER_BEGIN_NAMESPACE
 class WOutput;
@@ -21,26 +24,56 @@ WAYLIB_SERVER_END_NAMESPACE
 
 WAYLIB_SERVER_USE_NAMESPACE
 
+class FrameStats;
+class QmlEngine;
+
 class Output : public QObject
 {
     Q_OBJECT
     QML_ANONYMOUS
     Q_PROPERTY(WOutputItem* outputItem MEMBER m_item CONSTANT)
     Q_PROPERTY(WOutputViewport* screenViewport MEMBER m_outputViewport CONSTANT)
+    Q_PROPERTY(FrameStats* stats READ stats CONSTANT)
 
 public:
     enum class Type { Primary, Proxy };
 
-    static Output *createPrimary(WOutput *output, QQmlEngine *engine, QObject *parent = nullptr);
+    static Output *createPrimary(WOutput *output, QmlEngine *engine, QObject *parent = nullptr);
     static Output *createCopy(WOutput *output,
                               Output *proxy,
-                              QQmlEngine *engine,
+                              QmlEngine *engine,
                               QObject *parent = nullptr);
 
+    // Initial properties and wrappers for items created from
+    // QmlEngine::primaryOutputComponent() and copyOutputComponent() by other
+    // means, e.g. QmlEngine::incubate().
+    static QVariantMap primaryProperties(WOutput *output);
+    static QVariantMap copyProperties(Output *proxy);
+    static Output *fromPrimaryItem(WOutput *output, QObject *item, QObject *parent = nullptr);
+    static Output *fromCopyItem(WOutput *output,
+                                Output *proxy,
+                                QObject *item,
+                                QObject *parent = nullptr);
+
     explicit Output(WOutputItem *output, QObject *parent = nullptr);
     ~Output();
 
+    // Number of Output objects alive, to find leaks.
+    static int liveCount();
+
     bool isPrimary() const;
+    Output *proxy() const;
+    // Re-targets a copy output to mirror another primary output.
+    void setProxy(Output *proxy);
+    // An inactive output is hidden and detached from its WOutput, so it can
+    // be kept while the other representation of the output is used.
+    bool isActive() const;
+    void setActive(bool active);
+    // True while a copy output shows the buffers of its proxy directly,
+    // instead of composing them in a render pass of its own.
+    bool isDirectScanout() const;
+    // True once a buffer has been committed to the output.
+    bool hasFrame() const;
 
     WOutput *output() const;
     WOutputItem *outputItem() const;
@@ -48,6 +81,9 @@ public:
     QRectF rect() const;
     QRectF geometry() const;
     WOutputViewport *screenViewport() const;
+    // The viewport rendering to this output, for a copy it isn't screenViewport().
+    WOutputViewport *renderViewport() const;
+    FrameStats *stats() const;
     void updatePositionFromLayout();
 
 public Q_SLOTS:
@@ -55,14 +91,26 @@ public Q_SLOTS:
 
 private:
     std::pair<WOutputViewport *, QQuickItem *> getOutputItemProperty();
+    void setProxyAttached(bool attached);
+    void onProxyCommit(wlr_output_event_commit *event);
+    bool canScanoutFrom(Output *source) const;
+    void setDirectScanout(bool directScanout);
 
     Type m_type;
     WOutputItem *m_item;
     Output *m_proxy = nullptr;
     QPointer<QQuickItem> m_menuBar;
     WOutputViewport *m_outputViewport;
+    bool m_hasFrame = false;
+    bool m_active = true;
+    bool m_directScanout = false;
+    QMetaObject::Connection m_hardwareLayersConnection;
+    QMetaObject::Connection m_proxyCommitConnection;
+    FrameStats *m_stats = nullptr;
 
     QList<WOutputLayer *> m_hardwareLayersOfPrimaryOutput;
+
+    inline static int m_liveCount = 0;
 };
 
 Q_DECLARE_OPAQUE_POINTER(WAYLIB_SERVER_NAMESPACE::WOutputItem *)
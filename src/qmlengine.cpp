@@ -3,80 +3,76 @@
 
 #include "qmlengine.h"
 
+#include "backgroundcache.h"
 #include "output.h"
+#include "themeconfig.h"
 #include "wayconfig.h"
 
 #include <woutputitem.h>
 
+#include <QCoreApplication>
 #include <QFile>
 #include <QQuickItem>
 #include <QStandardPaths>
 #include <QDir>
-#include <QQmlPropertyMap>
-#include <QSettings>
 #include <QQmlContext>
+#include <QQmlIncubator>
 #include <QFileInfo>
+#include <QTimer>
 
-class ThemeConfig : public QQmlPropertyMap
+#include <memory>
+#include <utility>
+
+Q_LOGGING_CATEGORY(qLcQmlEngine, "waygreet.qmlEngine")
+
+namespace {
+// The render window can't drive incubation, QQuickWindow::incubationController()
+// is null with QQuickRenderControl. Instead incubate for a slice of each event
+// loop pass while anything is incubating, frames are rendered in between.
+class IncubationController : public QObject, public QQmlIncubationController
 {
-    Q_OBJECT
 public:
-    explicit ThemeConfig(const QString &confPath, QObject *parent = nullptr)
-        : QQmlPropertyMap(this, parent)
+    explicit IncubationController(QObject *parent)
+        : QObject(parent)
     {
-        if (QFile::exists(confPath)) {
-            QSettings settings(confPath, QSettings::IniFormat);
-            // Qt's IniFormat maps [General] section keys to the top level —
-            // do NOT call beginGroup("General"), read childKeys() directly.
-            for (const QString &key : settings.childKeys()) {
-                insert(key, settings.value(key));
-            }
-        }
+        m_timer.setInterval(0);
+        connect(&m_timer, &QTimer::timeout, this, [this] {
+            incubateFor(SliceMs);
+        });
     }
 
-    Q_INVOKABLE QString stringValue(const QString &key) const {
-        return value(key).toString();
-    }
-    Q_INVOKABLE bool boolValue(const QString &key) const {
-        QVariant v = value(key);
-        // QSettings::IniFormat stores true/false as plain strings;
-        // QVariant::toBool() does not convert them, so handle explicitly.
-        if (v.typeId() == QMetaType::QString) {
-            const QString s = v.toString().toLower();
-            return s == QStringLiteral("true") || s == QStringLiteral("1") || s == QStringLiteral("yes");
-        }
-        return v.toBool();
-    }
-    Q_INVOKABLE int intValue(const QString &key) const {
-        return value(key).toInt();
-    }
-    Q_INVOKABLE qreal realValue(const QString &key) const {
-        QVariant v = value(key);
-        // QSettings::IniFormat may store decimal values as strings.
-        if (v.typeId() == QMetaType::QString) {
-            bool ok = false;
-            qreal r = v.toString().toDouble(&ok);
-            return ok ? r : 0.0;
-        }
-        return v.toReal();
+protected:
+    void incubatingObjectCountChanged(int count) override
+    {
+        if (count > 0)
+            m_timer.start();
+        else
+            m_timer.stop();
     }
-};
 
-
-Q_LOGGING_CATEGORY(qLcQmlEngine, "waygreet.qmlEngine")
+private:
+    static constexpr int SliceMs = 4;
+    QTimer m_timer;
+};
+} // namespace
 
 QmlEngine::QmlEngine(QObject *parent)
     : QQmlApplicationEngine(parent)
     , menuBarComponent(this, "WayGreet", "OutputMenuBar")
+    , m_primaryOutputComponent(this, "WayGreet", "PrimaryOutput")
+    , m_copyOutputComponent(this, "WayGreet", "CopyOutput")
 {
-
+    addImageProvider("background", new BackgroundImageProvider);
+    setIncubationController(new IncubationController(this));
 }
 
-QQuickItem *QmlEngine::createMenuBar(WOutputItem *output, QQuickItem *parent)
+QQuickItem *QmlEngine::createMenuBar(WOutputItem *output, QObject *stats, QQuickItem *parent)
 {
     auto context = qmlContext(parent);
     auto obj = menuBarComponent.beginCreate(context);
-    menuBarComponent.setInitialProperties(obj, { { "output", QVariant::fromValue(output) } });
+    menuBarComponent.setInitialProperties(obj,
+                                          { { "output", QVariant::fromValue(output) },
+                                            { "stats", QVariant::fromValue(stats) } });
     auto item = qobject_cast<QQuickItem *>(obj);
     Q_ASSERT(item);
     item->setParent(parent);
@@ -86,61 +82,268 @@ QQuickItem *QmlEngine::createMenuBar(WOutputItem *output, QQuickItem *parent)
     return item;
 }
 
-QQuickItem *QmlEngine::createGreeter(WOutputItem *output, QObject *parent)
+QQmlComponent *QmlEngine::primaryOutputComponent()
 {
-    if (!greeterComponent) {
-        greeterComponent = new QQmlComponent(this);
-        auto themeName = WayConfig::instance()->theme();
-        QString themePath;
+    return &m_primaryOutputComponent;
+}
 
-        if (!themeName.isEmpty()) {
-            auto customThemeDir = WayConfig::instance()->themeDir();
+QQmlComponent *QmlEngine::copyOutputComponent()
+{
+    return &m_copyOutputComponent;
+}
 
-            if (!customThemeDir.isEmpty()) {
-                themePath = QDir(customThemeDir).filePath(themeName + "/Main.qml");
-            } else if (themeName.startsWith("/")) {
-                themePath = themeName + "/Main.qml";
-            } else {
-                QString relPath = QStringLiteral("waygreet/themes/%1/Main.qml").arg(themeName);
-                themePath = QStandardPaths::locate(QStandardPaths::GenericDataLocation, relPath);
-            }
+namespace {
+class Incubator : public QQmlIncubator
+{
+public:
+    Incubator(QObject *receiver, std::function<void(QObject *)> ready)
+        : QQmlIncubator(Asynchronous)
+        , m_receiver(receiver)
+        , m_ready(std::move(ready))
+    {
+    }
+
+protected:
+    void statusChanged(Status status) override
+    {
+        if (status != Ready && status != Error)
+            return;
+
+        QObject *obj = object();
+        if (status == Error) {
+            qCWarning(qLcQmlEngine) << "Failed to incubate:" << errors();
+            obj = nullptr;
         }
 
-        if (!themePath.isEmpty()) {
-            QFileInfo fi(themePath);
-            QString confPath = fi.dir().filePath("theme.conf");
-            rootContext()->setContextProperty("config", new ThemeConfig(confPath, this));
-
-            if (QFile::exists(themePath)) {
-                greeterComponent->loadUrl(QUrl::fromLocalFile(themePath));
-            } else {
-                qCWarning(qLcQmlEngine) << "Theme file not found for:" << themeName << "fallback to default";
-            }
-        } else {
-            rootContext()->setContextProperty("config", new ThemeConfig("", this));
+        if (m_receiver)
+            m_ready(obj);
+        else
+            delete obj;
+
+        // Can't delete the incubator while it's still reporting the status.
+        QMetaObject::invokeMethod(
+            qApp,
+            [this] {
+                delete this;
+            },
+            Qt::QueuedConnection);
+    }
+
+private:
+    QPointer<QObject> m_receiver;
+    std::function<void(QObject *)> m_ready;
+};
+} // namespace
+
+void QmlEngine::incubate(QQmlComponent *component,
+                         const QVariantMap &properties,
+                         QObject *receiver,
+                         std::function<void(QObject *)> ready)
+{
+    auto incubator = new Incubator(receiver, std::move(ready));
+    incubator->setInitialProperties(properties);
+    component->create(*incubator, rootContext());
+}
+
+QString QmlEngine::themePath(const QString &themeName)
+{
+    if (themeName.isEmpty())
+        return {};
+
+    auto customThemeDir = WayConfig::instance()->themeDir();
+    if (!customThemeDir.isEmpty())
+        return QDir(customThemeDir).filePath(themeName + "/Main.qml");
+    if (themeName.startsWith("/"))
+        return themeName + "/Main.qml";
+
+    QString relPath = QStringLiteral("waygreet/themes/%1/Main.qml").arg(themeName);
+    return QStandardPaths::locate(QStandardPaths::GenericDataLocation, relPath);
+}
+
+QmlEngine::Theme *QmlEngine::loadTheme(const QString &themeName,
+                                       QQmlComponent::CompilationMode mode)
+{
+    auto it = m_themes.find(themeName);
+    if (it != m_themes.end())
+        return &it.value();
+
+    Theme &theme = m_themes[themeName];
+    theme.lastUsed = ++m_themeUseCounter;
+    theme.component = new QQmlComponent(this);
+    theme.context = new QQmlContext(rootContext(), this);
+
+    const QString path = themePath(themeName);
+    theme.config = new ThemeConfig(path.isEmpty() ? QString()
+                                                  : QFileInfo(path).dir().filePath("theme.conf"),
+                                   this);
+    theme.context->setContextProperty("config", theme.config);
+
+    auto component = theme.component;
+    auto fellBack = std::make_shared<bool>(false);
+    auto fallback = [component, fellBack] {
+        if (component->isError())
+            qCWarning(qLcQmlEngine) << "Theme load error:" << component->errorString();
+        // The built-in Greeter failing as well must not fall back to itself.
+        if (std::exchange(*fellBack, true))
+            return;
+        component->loadFromModule("WayGreet", "Greeter");
+    };
+
+    if (path.isEmpty()) {
+        fallback();
+    } else if (!QFile::exists(path)) {
+        qCWarning(qLcQmlEngine) << "Theme file not found for:" << themeName << "fallback to default";
+        fallback();
+    } else {
+        // Asynchronous compiles the theme on the type loader thread, a later
+        // switch to it only has to instantiate the component.
+        connect(component, &QQmlComponent::statusChanged, this, [component, fallback] {
+            if (component->isError())
+                fallback();
+        });
+        component->loadUrl(QUrl::fromLocalFile(path), mode);
+    }
+
+    return &theme;
+}
+
+void QmlEngine::releaseTheme(Theme &theme)
+{
+    delete theme.component;
+    delete theme.context;
+    delete theme.config;
+    theme = {};
+}
+
+void QmlEngine::evictThemes()
+{
+    const int limit = qMax(1, WayConfig::instance()->themeCacheLimit());
+    bool evicted = false;
+
+    while (m_themes.size() > limit) {
+        auto victim = m_themes.end();
+        for (auto it = m_themes.begin(); it != m_themes.end(); ++it) {
+            // Keep the current theme and any theme whose greeter is still alive.
+            if (it.key() == currentTheme() || it->greeter)
+                continue;
+            if (victim == m_themes.end() || it->lastUsed < victim->lastUsed)
+                victim = it;
         }
 
-        if (greeterComponent->isNull() || greeterComponent->isError()) {
-            if (greeterComponent->isError()) {
-                qCWarning(qLcQmlEngine) << "Theme load error:" << greeterComponent->errorString();
-            }
-            greeterComponent->loadFromModule("WayGreet", "Greeter");
+        if (victim == m_themes.end())
+            break;
+
+        qCDebug(qLcQmlEngine) << "Evict theme:" << victim.key();
+        releaseTheme(victim.value());
+        m_themes.erase(victim);
+        evicted = true;
+    }
+
+    if (evicted)
+        trimComponentCache();
+}
+
+int QmlEngine::releaseInactiveThemes()
+{
+    int released = 0;
+    for (auto it = m_themes.begin(); it != m_themes.end();) {
+        if (it.key() == currentTheme() || it->greeter) {
+            ++it;
+            continue;
         }
+        releaseTheme(it.value());
+        it = m_themes.erase(it);
+        ++released;
     }
+    return released;
+}
 
-    auto context = qmlContext(parent);
-    auto obj = greeterComponent->beginCreate(context);
+QString QmlEngine::currentTheme() const
+{
+    return m_currentTheme.value_or(WayConfig::instance()->theme());
+}
+
+bool QmlEngine::setCurrentTheme(const QString &themeName)
+{
+    if (themeName == currentTheme())
+        return false;
+
+    m_currentTheme = themeName;
+    auto theme = loadTheme(themeName, QQmlComponent::Asynchronous);
+    theme->lastUsed = ++m_themeUseCounter;
+
+    auto component = theme->component;
+    if (!component->isLoading()) {
+        Q_EMIT currentThemeChanged();
+        return true;
+    }
+
+    auto connection = std::make_shared<QMetaObject::Connection>();
+    *connection = connect(component,
+                          &QQmlComponent::statusChanged,
+                          this,
+                          [this, component, themeName, connection] {
+                              if (component->isLoading())
+                                  return;
+                              disconnect(*connection);
+                              if (currentTheme() == themeName)
+                                  Q_EMIT currentThemeChanged();
+                          });
+
+    return true;
+}
+
+void QmlEngine::preloadThemes(const QStringList &themeNames)
+{
+    for (const auto &themeName : themeNames) {
+        // The current theme is compiled synchronously by createGreeter().
+        if (themeName == currentTheme() || m_themes.contains(themeName))
+            continue;
+        qCDebug(qLcQmlEngine) << "Preload theme:" << themeName;
+        loadTheme(themeName, QQmlComponent::Asynchronous);
+    }
+
+    evictThemes();
+}
+
+void QmlEngine::createGreeter(QObject *parent,
+                              std::function<WOutputItem *()> output,
+                              std::function<void(QQuickItem *)> ready)
+{
+    auto theme = loadTheme(currentTheme(), QQmlComponent::PreferSynchronous);
+    auto component = theme->component;
+    if (component->isLoading()) {
+        // Preloading of this theme is still running. Waiting in a nested event
+        // loop would dispatch Wayland, input and output commits from inside the
+        // caller, try again once it is done. The current theme may have
+        // changed by then.
+        auto connection = std::make_shared<QMetaObject::Connection>();
+        *connection = connect(component,
+                              &QQmlComponent::statusChanged,
+                              parent,
+                              [this, component, parent, output, ready, connection] {
+                                  if (component->isLoading())
+                                      return;
+                                  disconnect(*connection);
+                                  createGreeter(parent, output, ready);
+                              });
+        return;
+    }
+    theme->lastUsed = ++m_themeUseCounter;
+
+    auto obj = component->beginCreate(theme->context);
     if (!obj) {
-        qCFatal(qLcQmlEngine) << "Can't create Greeter:" << greeterComponent->errorString();
+        qCFatal(qLcQmlEngine) << "Can't create Greeter:" << component->errorString();
     }
-    //greeterComponent->setInitialProperties(obj, { { "output", QVariant::fromValue(output) } });
+    //component->setInitialProperties(obj, { { "output", QVariant::fromValue(output) } });
     auto item = qobject_cast<QQuickItem *>(obj);
     Q_ASSERT(item);
     item->setParent(parent);
-    item->setParentItem(output);
-    greeterComponent->completeCreate();
+    item->setParentItem(output());
+    component->completeCreate();
+    theme->greeter = item;
 
-    return item;
-}
+    evictThemes();
 
-#include "qmlengine.moc"
+    ready(item);
+}
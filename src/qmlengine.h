@@ -5,9 +5,14 @@
 
 #include <wglobal.h>
 
+#include <QHash>
+#include <QPointer>
 #include <QQmlApplicationEngine>
 #include <QQmlComponent>
 
+#include <functional>
+#include <optional>
+
 QT_BEGIN_NAMESPACE
 class QQuickItem;
 QT_END_NAMESPACE
@@ -18,16 +23,62 @@ WAYLIB_SERVER_END_NAMESPACE
 
 WAYLIB_SERVER_USE_NAMESPACE
 
+class ThemeConfig;
+
 class QmlEngine : public QQmlApplicationEngine
 {
     Q_OBJECT
 public:
     explicit QmlEngine(QObject *parent = nullptr);
 
-    QQuickItem *createMenuBar(WOutputItem *output, QQuickItem *parent);
-    QQuickItem *createGreeter(WOutputItem *output, QObject *parent);
+    QQuickItem *createMenuBar(WOutputItem *output, QObject *stats, QQuickItem *parent);
+    // Creates the current theme's greeter on the item output() returns at that
+    // time. If the theme is still compiling it returns at once and ready is
+    // called once it is done, not at all if parent is gone.
+    void createGreeter(QObject *parent,
+                       std::function<WOutputItem *()> output,
+                       std::function<void(QQuickItem *)> ready);
+
+    QQmlComponent *primaryOutputComponent();
+    QQmlComponent *copyOutputComponent();
+    // Creates an object of component a few milliseconds per event loop pass,
+    // instead of blocking the frames in between. ready is
+    // called with nullptr if it fails, and not at all if receiver is gone.
+    void incubate(QQmlComponent *component,
+                  const QVariantMap &properties,
+                  QObject *receiver,
+                  std::function<void(QObject *)> ready);
+
+    QString currentTheme() const;
+    bool setCurrentTheme(const QString &themeName);
+    void preloadThemes(const QStringList &themeNames);
+    // Drops every compiled theme but the current one, returns how many.
+    int releaseInactiveThemes();
+    // Main.qml of a theme name or directory, empty if there is none.
+    static QString themePath(const QString &themeName);
+
+Q_SIGNALS:
+    // Emitted once the component of the new current theme is ready to create.
+    void currentThemeChanged();
 
 private:
+    struct Theme
+    {
+        QQmlComponent *component = nullptr;
+        QQmlContext *context = nullptr;
+        ThemeConfig *config = nullptr;
+        QPointer<QQuickItem> greeter;
+        quint64 lastUsed = 0;
+    };
+
+    Theme *loadTheme(const QString &themeName, QQmlComponent::CompilationMode mode);
+    void releaseTheme(Theme &theme);
+    void evictThemes();
+
     QQmlComponent menuBarComponent;
-    QQmlComponent *greeterComponent = nullptr;
+    QQmlComponent m_primaryOutputComponent;
+    QQmlComponent m_copyOutputComponent;
+    QHash<QString, Theme> m_themes;
+    std::optional<QString> m_currentTheme;
+    quint64 m_themeUseCounter = 0;
 };
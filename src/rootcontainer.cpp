@@ -44,7 +44,9 @@ void RootContainer::init(WServer *server)
 
     m_outputLayout->safeConnect(&qw_output_layout::notify_change, this, [this] {
         for (auto output : std::as_const(outputs())) {
-            output->updatePositionFromLayout();
+            // Copy outputs are not part of the layout.
+            if (output->isPrimary())
+                output->updatePositionFromLayout();
         }
 
         ensureCursorVisible();
@@ -82,6 +84,18 @@ void RootContainer::setPrimaryOutput(Output *newPrimaryOutput)
     if (m_primaryOutput == newPrimaryOutput)
         return;
     m_primaryOutput = newPrimaryOutput;
+
+    if (m_primaryOutput) {
+        auto retarget = [this](Output *o) {
+            if (!o->isPrimary() && o->output() != m_primaryOutput->output())
+                o->setProxy(m_primaryOutput);
+        };
+        for (auto o : std::as_const(m_outputList))
+            retarget(o);
+        for (auto o : std::as_const(m_standbyOutputs))
+            retarget(o);
+    }
+
     emit primaryOutputChanged();
 }
 
@@ -137,22 +151,9 @@ void RootContainer::enableOutput(WOutput *output)
     }
 }
 
-int RootContainer::indexOfOutput(WOutput *output) const
-{
-    for (int i = 0; i < m_outputList.size(); i++) {
-        if (m_outputList.at(i)->output() == output)
-            return i;
-    }
-    return -1;
-}
-
 Output *RootContainer::getOutput(WOutput *output) const
 {
-    for (auto o : std::as_const(m_outputList)) {
-        if (o->output() == output)
-            return o;
-    }
-    return nullptr;
+    return m_outputMap.value(output);
 }
 
 void RootContainer::setOutputMode(OutputMode mode)
@@ -161,29 +162,44 @@ void RootContainer::setOutputMode(OutputMode mode)
         return;
 
     m_mode = mode;
-    for (int i = 0; i < m_outputList.size(); i++) {
-        if (m_outputList.at(i) == primaryOutput())
+    const auto outputs = m_outputList;
+    for (auto old : outputs) {
+        if (old == primaryOutput())
             continue;
 
-        Output *o = nullptr;
-        if (mode == OutputMode::Extension) {
-            o = Output::createPrimary(m_outputList.at(i)->output(),
-                                      Helper::instance()->qmlEngine(),
-                                      this);
-            o->outputItem()->stackBefore(this);
-            addOutput(o);
-            enableOutput(o->output());
-        } else { // Copy
-            o = Output::createCopy(m_outputList.at(i)->output(),
-                                   primaryOutput(),
-                                   Helper::instance()->qmlEngine(),
-                                   this);
-            removeOutput(o);
-        }
+        replaceOutput(old, takeStandbyOutput(old->output(), mode == OutputMode::Extension));
+    }
+}
 
-        m_outputList.at(i)->deleteLater();
-        m_outputList.replace(i, o);
+Output *RootContainer::takeStandbyOutput(WOutput *output, bool primary)
+{
+    if (auto o = m_standbyOutputs.take(output)) {
+        Q_ASSERT(o->isPrimary() == primary);
+        return o;
     }
+
+    if (primary) {
+        auto o = Output::createPrimary(output, Helper::instance()->qmlEngine(), this);
+        o->outputItem()->stackBefore(this);
+        return o;
+    }
+
+    return Output::createCopy(output, primaryOutput(), Helper::instance()->qmlEngine(), this);
+}
+
+void RootContainer::replaceOutput(Output *output, Output *newOutput)
+{
+    Q_ASSERT(output->output() == newOutput->output());
+    removeOutput(output);
+    output->setActive(false);
+    m_standbyOutputs.insert(output->output(), output);
+
+    if (!newOutput->isPrimary())
+        newOutput->setProxy(primaryOutput());
+    newOutput->setActive(true);
+    addOutput(newOutput);
+    if (newOutput->isPrimary())
+        enableOutput(newOutput->output());
 }
 
 RootContainer::OutputMode RootContainer::outputMode() const
@@ -191,27 +207,115 @@ RootContainer::OutputMode RootContainer::outputMode() const
     return m_mode;
 }
 
+bool RootContainer::outputsPowered() const
+{
+    return m_outputsPowered;
+}
+
+void RootContainer::setOutputsPowered(bool powered)
+{
+    if (m_outputsPowered == powered)
+        return;
+
+    m_outputsPowered = powered;
+    for (auto o : std::as_const(m_outputList)) {
+        auto qwoutput = o->output()->handle();
+        // Stop rendering before the output goes away, and only resume once it's back.
+        if (!powered)
+            o->renderViewport()->setLive(false);
+
+        qw_output_state newState;
+        newState.set_enabled(powered);
+        if (powered && !qwoutput->handle()->current_mode) {
+            if (auto mode = qwoutput->preferred_mode())
+                newState.set_mode(mode);
+        }
+        if (!qwoutput->commit_state(newState))
+            qWarning() << "Failed to" << (powered ? "enable" : "disable") << "output"
+                       << qwoutput->handle()->name;
+
+        if (powered)
+            o->renderViewport()->setLive(true);
+    }
+
+    if (powered)
+        window()->update();
+}
+
 void RootContainer::onOutputAdded(WOutput *output)
 {
     allowNonDrmOutputAutoChangeMode(output);
-    Output *o;
-    if (m_mode == OutputMode::Extension || !primaryOutput()) {
-        o = Output::createPrimary(output, Helper::instance()->qmlEngine(), this);
-        o->outputItem()->stackBefore(this);
+    const bool primary = m_mode == OutputMode::Extension || !primaryOutput();
+
+    // Nothing renders yet, there are no frames to keep smooth.
+    if (m_outputList.isEmpty()) {
+        Output *o;
+        if (primary) {
+            o = Output::createPrimary(output, Helper::instance()->qmlEngine(), this);
+            o->outputItem()->stackBefore(this);
+        } else {
+            o = Output::createCopy(output, primaryOutput(), Helper::instance()->qmlEngine(), this);
+        }
+
         addOutput(o);
-    } else if (m_mode == OutputMode::Copy) {
-        o = Output::createCopy(output, primaryOutput(), Helper::instance()->qmlEngine(), this);
+        enableOutput(output);
+        return;
     }
 
-    enableOutput(output);
+    // Don't stall the frames of the existing outputs on instantiating QML.
+    auto engine = Helper::instance()->qmlEngine();
+    m_pendingOutputs.insert(output);
+    engine->incubate(primary ? engine->primaryOutputComponent() : engine->copyOutputComponent(),
+                     primary ? Output::primaryProperties(output)
+                             : Output::copyProperties(primaryOutput()),
+                     this,
+                     [this, output, primary, guard = QPointer(output)](QObject *obj) {
+                         // Removed while incubating.
+                         if (!guard || !m_pendingOutputs.remove(output)) {
+                             delete obj;
+                             return;
+                         }
+
+                         if (!obj) {
+                             qWarning() << "Failed to create output" << output->name();
+                             return;
+                         }
+
+                         Output *o;
+                         if (primary) {
+                             o = Output::fromPrimaryItem(output, obj, this);
+                             o->outputItem()->stackBefore(this);
+                         } else if (primaryOutput()) {
+                             // The primary output may have changed meanwhile.
+                             o = Output::fromCopyItem(output, primaryOutput(), obj, this);
+                         } else {
+                             delete obj;
+                             o = Output::createPrimary(output, Helper::instance()->qmlEngine(), this);
+                             o->outputItem()->stackBefore(this);
+                         }
+
+                         addOutput(o);
+                         enableOutput(output);
+                     });
 }
 
 void RootContainer::onOutputRemoved(WOutput *output)
 {
-    auto index = indexOfOutput(output);
-    Q_ASSERT(index >= 0);
-    const auto o = m_outputList.takeAt(index);
+    if (m_pendingOutputs.remove(output))
+        return;
+
+    const auto o = getOutput(output);
+    Q_ASSERT(o);
     removeOutput(o);
+
+    // Only the primary output is in the layout in copy mode, promote a
+    // mirror before the copies lose their source.
+    if (!m_primaryOutput && !m_outputList.isEmpty()) {
+        auto next = m_outputList.first();
+        replaceOutput(next, takeStandbyOutput(next->output(), true));
+    }
+
+    delete m_standbyOutputs.take(output);
     delete o;
     if (outputs().isEmpty() && Helper::instance()->isTestMode())
         qApp->quit();
@@ -219,7 +323,13 @@ void RootContainer::onOutputRemoved(WOutput *output)
 
 void RootContainer::addOutput(Output *output)
 {
+    Q_ASSERT(!m_outputMap.contains(output->output()));
     m_outputList.append(output);
+    m_outputMap.insert(output->output(), output);
+
+    if (!output->isPrimary())
+        return;
+
     m_outputLayout->autoAdd(output->output());
     if (!m_primaryOutput)
         setPrimaryOutput(output);
@@ -227,13 +337,17 @@ void RootContainer::addOutput(Output *output)
 
 void RootContainer::removeOutput(Output *output)
 {
+    // Unregister first, the primary output is looked up by the layout below.
+    m_outputList.removeOne(output);
+    m_outputMap.remove(output->output());
+
+    if (!output->isPrimary())
+        return;
+
     m_outputLayout->remove(output->output());
     if (m_primaryOutput == output) {
         const auto outputs = m_outputLayout->outputs();
-        if (!outputs.isEmpty()) {
-            auto newPrimaryOutput = getOutput(outputs.first());
-            setPrimaryOutput(newPrimaryOutput);
-        }
+        setPrimaryOutput(outputs.isEmpty() ? nullptr : getOutput(outputs.first()));
     }
 
     // ensure cursor within output
@@ -247,5 +361,4 @@ void RootContainer::removeOutput(Output *output)
         else
             Helper::instance()->setCursorPosition(m_primaryOutput->geometry().center());
     }
-    m_outputList.removeOne(output);
 }
@@ -9,6 +9,8 @@
 #include <wglobal.h>
 #include <WOutput>
 
+#include <QHash>
+#include <QSet>
 #include <QQuickItem>
 
 WAYLIB_SERVER_BEGIN_NAMESPACE
@@ -44,12 +46,14 @@ public:
     const QList<Output *> &outputs() const;
 
     void enableOutput(WOutput *output);
-    int indexOfOutput(WOutput *output) const;
     Output *getOutput(WOutput *output) const;
 
     OutputMode outputMode() const;
     void setOutputMode(OutputMode mode);
 
+    bool outputsPowered() const;
+    void setOutputsPowered(bool powered);
+
 public Q_SLOTS:
     void onOutputAdded(WOutput *output);
     void onOutputRemoved(WOutput *output);
@@ -60,15 +64,25 @@ Q_SIGNALS:
 private:
     void addOutput(Output *output);
     void removeOutput(Output *output);
+    Output *takeStandbyOutput(WOutput *output, bool primary);
+    void replaceOutput(Output *output, Output *newOutput);
 
     void ensureCursorVisible();
     void allowNonDrmOutputAutoChangeMode(WOutput *output);
 
+    // Primary and copy outputs, m_outputMap must be kept in sync with it.
     QList<Output *> m_outputList;
+    QHash<WOutput *, Output *> m_outputMap;
+    // The inactive representation of each output, created on the first mode
+    // switch and reused afterwards so switching doesn't instantiate QML.
+    QHash<WOutput *, Output *> m_standbyOutputs;
+    // Outputs whose QML items are being incubated.
+    QSet<WOutput *> m_pendingOutputs;
     QPointer<Output> m_primaryOutput;
     WOutputLayout *m_outputLayout = nullptr;
     WCursor *m_cursor = nullptr;
     OutputMode m_mode = OutputMode::Extension;
+    bool m_outputsPowered = true;
 };
 
 Q_DECLARE_OPAQUE_POINTER(WAYLIB_SERVER_NAMESPACE::WOutputLayout *)
@@ -82,11 +82,42 @@ public:
     }
 };
 
+class SessionData : public QSharedData
+{
+public:
+    bool valid = false;
+    Session::Type type = Session::UnknownSession;
+    int vt = 0;
+    QDir dir;
+    QString fileName;
+    QString displayName;
+    QString comment;
+    QString exec;
+    QString tryExec;
+    QString xdgSessionType;
+    QString desktopNames;
+    QProcessEnvironment additionalEnv;
+    bool isHidden = false;
+    bool isNoDisplay = false;
+};
+
+static QProcessEnvironment parseEnv(const QString &fileName, const QString &list)
+{
+    QProcessEnvironment env;
+    const auto entryList = QStringView{ list }.split(u',', Qt::SkipEmptyParts);
+    for (const auto &entry : entryList) {
+        int midPoint = entry.indexOf(QLatin1Char('='));
+        if (midPoint < 0) {
+            qWarning() << "Malformed entry in" << fileName << ":" << entry;
+            continue;
+        }
+        env.insert(entry.left(midPoint).toString(), entry.mid(midPoint + 1).toString());
+    }
+    return env;
+}
+
 Session::Session()
-    : m_valid(false)
-    , m_type(UnknownSession)
-    , m_isHidden(false)
-    , m_isNoDisplay(false)
+    : d(new SessionData)
 {
 }
 
@@ -96,84 +127,90 @@ Session::Session(Type type, const QString &fileName)
     setTo(type, fileName);
 }
 
+Session::Session(const Session &other) = default;
+
+Session::~Session() = default;
+
+Session &Session::operator=(const Session &other) = default;
+
 bool Session::isValid() const
 {
-    return m_valid;
+    return d->valid;
 }
 
 Session::Type Session::type() const
 {
-    return m_type;
+    return d->type;
 }
 
 int Session::vt() const
 {
-    return m_vt;
+    return d->vt;
 }
 
 void Session::setVt(int vt)
 {
-    m_vt = vt;
+    d->vt = vt;
 }
 
 QString Session::xdgSessionType() const
 {
-    return m_xdgSessionType;
+    return d->xdgSessionType;
 }
 
 QDir Session::directory() const
 {
-    return m_dir;
+    return d->dir;
 }
 
 QString Session::fileName() const
 {
-    return m_fileName;
+    return d->fileName;
 }
 
 QString Session::displayName() const
 {
-    return m_displayName;
+    return d->displayName;
 }
 
 QString Session::comment() const
 {
-    return m_comment;
+    return d->comment;
 }
 
 QString Session::exec() const
 {
-    return m_exec;
+    return d->exec;
 }
 
 QString Session::tryExec() const
 {
-    return m_tryExec;
+    return d->tryExec;
 }
 
 QString Session::desktopSession() const
 {
-    return QFileInfo(m_fileName).completeBaseName();
+    return QFileInfo(d->fileName).completeBaseName();
 }
 
 QString Session::desktopNames() const
 {
-    return m_desktopNames;
+    return d->desktopNames;
 }
 
 bool Session::isHidden() const
 {
-    return m_isHidden;
+    return d->isHidden;
 }
 
 bool Session::isNoDisplay() const
 {
-    return m_isNoDisplay;
+    return d->isNoDisplay;
 }
 
 QProcessEnvironment Session::additionalEnv() const
 {
-    return m_additionalEnv;
+    return d->additionalEnv;
 }
 
 void Session::setTo(Type type, const QString &_fileName)
@@ -182,43 +219,42 @@ void Session::setTo(Type type, const QString &_fileName)
     if (!fileName.endsWith(s_entryExtention))
         fileName += s_entryExtention;
 
-    QFileInfo info(fileName);
-
-    m_type = UnknownSession;
-    m_valid = false;
-    m_desktopNames.clear();
+    // Shared with copies made before, don't modify it.
+    const int vt = std::as_const(d)->vt;
+    d = new SessionData;
+    d->vt = vt;
 
     QStringList SessionDirs;
 
     switch (type) {
     case WaylandSession:
         SessionDirs = WayConfig::instance()->waylandSessionDir();
-        m_xdgSessionType = QStringLiteral("wayland");
+        d->xdgSessionType = QStringLiteral("wayland");
         break;
     case X11Session:
         SessionDirs = WayConfig::instance()->x11SessionDir();
-        m_xdgSessionType = QStringLiteral("x11");
+        d->xdgSessionType = QStringLiteral("x11");
         break;
     default:
-        m_xdgSessionType.clear();
+        d->xdgSessionType.clear();
         break;
     }
 
     QFile file;
     for (const auto &path : std::as_const(SessionDirs)) {
-        m_dir.setPath(path);
-        m_fileName = m_dir.absoluteFilePath(fileName);
+        d->dir.setPath(path);
+        d->fileName = d->dir.absoluteFilePath(fileName);
 
-        qDebug() << "Reading from" << m_fileName;
+        qDebug() << "Reading from" << d->fileName;
 
-        file.setFileName(m_fileName);
+        file.setFileName(d->fileName);
         if (file.open(QIODevice::ReadOnly))
             break;
     }
     if (!file.isOpen())
         return;
 
-    QSettings settings(m_fileName, DesktopFileFormat::format());
+    QSettings settings(d->fileName, DesktopFileFormat::format());
     QStringList locales = { QLocale().name() };
     if (auto clean = QLocale().name().remove(QRegularExpression(QLatin1String("_.*")));
         clean != locales.constFirst()) {
@@ -242,42 +278,52 @@ void Session::setTo(Type type, const QString &_fileName)
         return settings.value(key).toString();
     };
 
-    m_displayName = localizedValue(QLatin1String("Name"));
-    m_comment = localizedValue(QLatin1String("Comment"));
-    m_exec = settings.value(QLatin1String("Exec"), QString()).toString();
-    m_tryExec = settings.value(QLatin1String("TryExec"), QString()).toString();
-    m_desktopNames = settings.value(QLatin1String("DesktopNames"), QString())
+    d->displayName = localizedValue(QLatin1String("Name"));
+    d->comment = localizedValue(QLatin1String("Comment"));
+    d->exec = settings.value(QLatin1String("Exec"), QString()).toString();
+    d->tryExec = settings.value(QLatin1String("TryExec"), QString()).toString();
+    d->desktopNames = settings.value(QLatin1String("DesktopNames"), QString())
                          .toString()
                          .replace(QLatin1Char(';'), QLatin1Char(':'));
     QString hidden = settings.value(QLatin1String("Hidden"), QString()).toString();
-    m_isHidden = hidden.toLower() == QLatin1String("true");
+    d->isHidden = hidden.toLower() == QLatin1String("true");
     QString noDisplay = settings.value(QLatin1String("NoDisplay"), QString()).toString();
-    m_isNoDisplay = noDisplay.toLower() == QLatin1String("true");
+    d->isNoDisplay = noDisplay.toLower() == QLatin1String("true");
     QString additionalEnv = settings.value(QLatin1String("X-SDDM-Env"), QString()).toString();
-    m_additionalEnv = parseEnv(additionalEnv);
+    d->additionalEnv = parseEnv(d->fileName, additionalEnv);
     settings.endGroup();
 
-    m_type = type;
-    m_valid = true;
+    d->type = type;
+    d->valid = true;
 }
 
-Session &Session::operator=(const Session &other)
+QDataStream &operator<<(QDataStream &stream, const Session &session)
 {
-    setTo(other.type(), other.fileName());
-    return *this;
+    const auto d = session.d.constData();
+    stream << d->valid << quint32(d->type) << qint32(d->vt) << d->dir.path() << d->fileName
+           << d->displayName << d->comment << d->exec << d->tryExec << d->xdgSessionType
+           << d->desktopNames << d->additionalEnv.toStringList() << d->isHidden
+           << d->isNoDisplay;
+    return stream;
 }
 
-QProcessEnvironment Session::parseEnv(const QString &list)
+QDataStream &operator>>(QDataStream &stream, Session &session)
 {
-    QProcessEnvironment env;
-    const auto entryList = QStringView{ list }.split(u',', Qt::SkipEmptyParts);
-    for (const auto &entry : entryList) {
-        int midPoint = entry.indexOf(QLatin1Char('='));
-        if (midPoint < 0) {
-            qWarning() << "Malformed entry in" << fileName() << ":" << entry;
-            continue;
-        }
-        env.insert(entry.left(midPoint).toString(), entry.mid(midPoint + 1).toString());
+    quint32 type;
+    qint32 vt;
+    QString dir;
+    QStringList env;
+    auto d = new SessionData;
+    stream >> d->valid >> type >> vt >> dir >> d->fileName >> d->displayName >> d->comment
+        >> d->exec >> d->tryExec >> d->xdgSessionType >> d->desktopNames >> env >> d->isHidden
+        >> d->isNoDisplay;
+    d->type = static_cast<Session::Type>(type);
+    d->vt = vt;
+    d->dir.setPath(dir);
+    for (const auto &entry : std::as_const(env)) {
+        const auto midPoint = entry.indexOf(QLatin1Char('='));
+        d->additionalEnv.insert(entry.left(midPoint), entry.mid(midPoint + 1));
     }
-    return env;
+    session.d = d;
+    return stream;
 }
@@ -9,15 +9,33 @@
 #include <QDataStream>
 #include <QDir>
 #include <QProcessEnvironment>
-#include <QSharedPointer>
+#include <QQmlEngine>
+#include <QSharedDataPointer>
 
+class SessionData;
+
+// Implicitly shared, copies don't read the .desktop file again.
 class Session
 {
+    Q_GADGET
+    QML_VALUE_TYPE(session)
+    Q_PROPERTY(bool valid READ isValid FINAL)
+    Q_PROPERTY(Type type READ type FINAL)
+    Q_PROPERTY(QString fileName READ fileName FINAL)
+    Q_PROPERTY(QString displayName READ displayName FINAL)
+    Q_PROPERTY(QString comment READ comment FINAL)
+    Q_PROPERTY(QString exec READ exec FINAL)
+    Q_PROPERTY(QString xdgSessionType READ xdgSessionType FINAL)
+    Q_PROPERTY(QString desktopNames READ desktopNames FINAL)
+
 public:
     enum Type { UnknownSession = 0, X11Session, WaylandSession };
+    Q_ENUM(Type)
 
     explicit Session();
     Session(Type type, const QString &fileName);
+    Session(const Session &other);
+    ~Session();
 
     bool isValid() const;
 
@@ -50,35 +68,12 @@ public:
     Session &operator=(const Session &other);
 
 private:
-    QProcessEnvironment parseEnv(const QString &list);
-    bool m_valid;
-    Type m_type;
-    int m_vt = 0;
-    QDir m_dir;
-    QString m_name;
-    QString m_fileName;
-    QString m_displayName;
-    QString m_comment;
-    QString m_exec;
-    QString m_tryExec;
-    QString m_xdgSessionType;
-    QString m_desktopNames;
-    QProcessEnvironment m_additionalEnv;
-    bool m_isHidden;
-    bool m_isNoDisplay;
-};
+    QSharedDataPointer<SessionData> d;
 
-inline QDataStream &operator<<(QDataStream &stream, const Session &WSession)
-{
-    stream << quint32(WSession.type()) << WSession.fileName();
-    return stream;
-}
+    friend QDataStream &operator<<(QDataStream &stream, const Session &session);
+    friend QDataStream &operator>>(QDataStream &stream, Session &session);
+};
 
-inline QDataStream &operator>>(QDataStream &stream, Session &WSession)
-{
-    quint32 type;
-    QString fileName;
-    stream >> type >> fileName;
-    WSession.setTo(static_cast<Session::Type>(type), fileName);
-    return stream;
-}
+// All fields are serialized, reading doesn't touch the .desktop file.
+QDataStream &operator<<(QDataStream &stream, const Session &session);
+QDataStream &operator>>(QDataStream &stream, Session &session);
@@ -2,13 +2,12 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "sessionipc.h"
-#include "session.h"
 
 #include "ipc.h"
 
 #include <QDebug>
 
-SessionIpc::SessionIpc(Ipc *ipc, Session *session, QObject *parent)
+SessionIpc::SessionIpc(Ipc *ipc, const Session &session, QObject *parent)
     : QObject(parent)
     , m_ipc(ipc)
     , m_session(session)
@@ -49,8 +48,9 @@ void SessionIpc::replyFinished(IpcReply *reply)
     if (reply->type() == QLatin1String("success")) {
         if (reply->requestType() == QLatin1String("create_session")
             || reply->requestType() == QLatin1String("post_auth_message_response")) {
-            auto command = QProcess::splitCommand(m_session->exec());
+            auto command = QProcess::splitCommand(m_session.exec());
             addRequest(m_ipc->startSession(command));
+            Q_EMIT authenticated();
             return;
         }
         if (reply->requestType() == QLatin1String("start_session")) {
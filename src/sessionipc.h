@@ -3,18 +3,19 @@
 
 #pragma once
 
+#include "session.h"
+
 #include <QObject>
 
 class Ipc;
 class IpcReply;
-class Session;
 
 class SessionIpc : public QObject
 {
     Q_OBJECT
 
 public:
-    explicit SessionIpc(Ipc *ipc, Session *session, QObject *parent = nullptr);
+    explicit SessionIpc(Ipc *ipc, const Session &session, QObject *parent = nullptr);
 
     void setUsername(const QString &username);
     void setPassword(const QString &password);
@@ -22,6 +23,8 @@ public:
     void start();
 
 Q_SIGNALS:
+    // The credentials were accepted, start_session is sent next.
+    void authenticated();
     void success();
     void error(const QString &errorType, const QString &description);
     void infoMessage(const QString &message);
@@ -32,7 +35,7 @@ private:
     void replyFinished(IpcReply *reply);
 
     Ipc *m_ipc { nullptr };
-    Session *m_session { nullptr };
+    Session m_session;
     QString m_username;
     QString m_password;
 };
@@ -15,43 +15,87 @@
 class SessionModelPrivate
 {
 public:
-    ~SessionModelPrivate()
-    {
-        qDeleteAll(sessions);
-        sessions.clear();
-    }
-
     int lastIndex{ 0 };
-    QStringList displayNames;
-    QVector<Session *> sessions;
+    QVector<Session> sessions;
+    // Disambiguated display name of each row.
+    QStringList names;
+    QFileSystemWatcher *watcher{ nullptr };
 };
 
 SessionModel::SessionModel(QObject *parent)
     : QAbstractListModel(parent)
     , d(new SessionModelPrivate())
+    , m_current(new CurrentSession(this))
+{
+}
+
+void SessionModel::load()
 {
     // initial population
+    reload();
+
+    // refresh everytime a file is changed, added or removed
+    if (d->watcher)
+        return;
+    d->watcher = new QFileSystemWatcher(this);
+    connect(d->watcher, &QFileSystemWatcher::directoryChanged, this, &SessionModel::reload);
+    d->watcher->addPaths(WayConfig::instance()->waylandSessionDir());
+    if (WayConfig::instance()->showX11Session())
+        d->watcher->addPaths(WayConfig::instance()->x11SessionDir());
+}
+
+void SessionModel::clear()
+{
+    delete d->watcher;
+    d->watcher = nullptr;
+
+    const bool hadSessions = !d->sessions.isEmpty();
+    const bool hadLastIndex = d->lastIndex != 0;
     beginResetModel();
+    d->sessions = {};
+    d->names = {};
+    d->lastIndex = 0;
+    endResetModel();
+
+    if (hadSessions)
+        Q_EMIT countChanged();
+    if (hadLastIndex)
+        Q_EMIT lastIndexChanged();
+}
+
+void SessionModel::reload()
+{
+    const int oldCount = d->sessions.size();
+    const int oldLastIndex = d->lastIndex;
+
+    // Recheck for flag to show Wayland sessions
+    beginResetModel();
+    d->sessions.clear();
+    d->names.clear();
+    d->lastIndex = 0;
     populate(Session::WaylandSession, WayConfig::instance()->waylandSessionDir());
     if (WayConfig::instance()->showX11Session())
         populate(Session::X11Session, WayConfig::instance()->x11SessionDir());
+
+    // Tell Wayland and X11 sessions of the same name apart.
+    QHash<QString, int> nameCount;
+    for (const auto &session : std::as_const(d->sessions))
+        ++nameCount[session.displayName()];
+
+    d->names.reserve(d->sessions.size());
+    for (const auto &session : std::as_const(d->sessions)) {
+        if (nameCount.value(session.displayName()) > 1
+            && session.type() == Session::WaylandSession)
+            d->names.append(tr("%1 (Wayland)").arg(session.displayName()));
+        else
+            d->names.append(session.displayName());
+    }
     endResetModel();
 
-    // refresh everytime a file is changed, added or removed
-    QFileSystemWatcher *watcher = new QFileSystemWatcher(this);
-    connect(watcher, &QFileSystemWatcher::directoryChanged, [this]() {
-        // Recheck for flag to show Wayland sessions
-        beginResetModel();
-        d->sessions.clear();
-        d->displayNames.clear();
-        populate(Session::WaylandSession, WayConfig::instance()->waylandSessionDir());
-        if (WayConfig::instance()->showX11Session())
-            populate(Session::X11Session, WayConfig::instance()->x11SessionDir());
-        endResetModel();
-    });
-    watcher->addPaths(WayConfig::instance()->waylandSessionDir());
-    if (WayConfig::instance()->showX11Session())
-        watcher->addPaths(WayConfig::instance()->x11SessionDir());
+    if (d->sessions.size() != oldCount)
+        Q_EMIT countChanged();
+    if (d->lastIndex != oldLastIndex)
+        Q_EMIT lastIndexChanged();
 }
 
 SessionModel::~SessionModel()
@@ -80,8 +124,8 @@ int SessionModel::lastIndex() const
 
 void SessionModel::setLastIndex(int index)
 {
-    if (const auto *session = get(index))
-        WayConfig::instance()->setLastSession(session->fileName());
+    if (const auto session = get(index); session.isValid())
+        WayConfig::instance()->setLastSession(session.fileName());
 }
 
 int SessionModel::rowCount(const QModelIndex &parent) const
@@ -89,11 +133,11 @@ int SessionModel::rowCount(const QModelIndex &parent) const
     return parent.isValid() ? 0 : d->sessions.length();
 }
 
-Session *SessionModel::get(int index)
+Session SessionModel::get(int index) const
 {
     if (index < 0 || index >= d->sessions.length())
-        return nullptr;
-    return d->sessions[index];
+        return Session();
+    return d->sessions.at(index);
 }
 
 QVariant SessionModel::data(const QModelIndex &index, int role) const
@@ -102,25 +146,22 @@ QVariant SessionModel::data(const QModelIndex &index, int role) const
         return QVariant();
 
     // get session
-    const auto *session = d->sessions[index.row()];
+    const auto &session = d->sessions.at(index.row());
 
     // return correct value
     switch (role) {
     case DirectoryRole:
-        return session->directory().absolutePath();
+        return session.directory().absolutePath();
     case FileRole:
-        return session->fileName();
+        return session.fileName();
     case TypeRole:
-        return session->type();
+        return session.type();
     case NameRole:
-        if (d->displayNames.count(session->displayName()) > 1
-            && session->type() == Session::WaylandSession)
-            return tr("%1 (Wayland)").arg(session->displayName());
-        return session->displayName();
+        return d->names.at(index.row());
     case ExecRole:
-        return session->exec();
+        return session.exec();
     case CommentRole:
-        return session->comment();
+        return session.comment();
     default:
         break;
     }
@@ -129,6 +170,11 @@ QVariant SessionModel::data(const QModelIndex &index, int role) const
     return QVariant();
 }
 
+CurrentSession *SessionModel::current() const
+{
+    return m_current;
+}
+
 void SessionModel::populate(Session::Type type, const QStringList &dirPaths)
 {
     // read session files
@@ -141,22 +187,22 @@ void SessionModel::populate(Session::Type type, const QStringList &dirPaths)
     }
     // read session
     sessions.removeDuplicates();
+    const QStringList pathList = QProcessEnvironment::systemEnvironment()
+                                     .value(QStringLiteral("PATH"))
+                                     .split(QLatin1Char(':'));
     for (auto &&session : std::as_const(sessions)) {
-        qDebug() << "Found Session: " << sessions;
-        auto *si = new Session(type, session);
+        qDebug() << "Found Session: " << session;
+        const Session si(type, session);
         bool execAllowed = true;
-        QFileInfo fi(si->tryExec());
+        QFileInfo fi(si.tryExec());
         if (fi.isAbsolute()) {
             if (!fi.exists() || !fi.isExecutable())
                 execAllowed = false;
         } else {
             execAllowed = false;
-            QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-            QString envPath = env.value(QStringLiteral("PATH"));
-            const QStringList pathList = envPath.split(QLatin1Char(':'));
             for (const QString &path : pathList) {
                 QDir pathDir(path);
-                fi.setFile(pathDir, si->tryExec());
+                fi.setFile(pathDir, si.tryExec());
                 if (fi.exists() && fi.isExecutable()) {
                     execAllowed = true;
                     break;
@@ -164,19 +210,107 @@ void SessionModel::populate(Session::Type type, const QStringList &dirPaths)
             }
         }
         // add to sessions list
-        if (!si->isHidden() && !si->isNoDisplay() && execAllowed) {
-            d->displayNames.append(si->displayName());
+        if (!si.isHidden() && !si.isNoDisplay() && execAllowed)
             d->sessions.push_back(si);
-        } else {
-            delete si;
-        }
     }
 
     // find out index of the last session
+    const QString lastSession = WayConfig::instance()->lastSession();
     for (int i = 0; i < d->sessions.size(); ++i) {
-        if (d->sessions.at(i)->fileName() == WayConfig::instance()->lastSession()) {
+        if (d->sessions.at(i).fileName() == lastSession) {
             d->lastIndex = i;
             break;
         }
     }
 }
+
+CurrentSession::CurrentSession(SessionModel *model)
+    : QObject(model)
+    , m_model(model)
+{
+    // Kept while the model is empty, e.g. cleared until a failed login
+    // reloads it.
+    connect(model, &QAbstractItemModel::modelAboutToBeReset, this, [this] {
+        if (!isValid())
+            return;
+        m_selectedFileName = fileName();
+        m_selectedType = type();
+    });
+    connect(model, &QAbstractItemModel::modelReset, this, &CurrentSession::modelReset);
+}
+
+int CurrentSession::index() const
+{
+    return m_index;
+}
+
+void CurrentSession::setIndex(int index)
+{
+    if (index < 0 || index >= m_model->rowCount() || index == m_index)
+        return;
+
+    m_index = index;
+    Q_EMIT changed();
+}
+
+bool CurrentSession::isValid() const
+{
+    return m_index >= 0 && m_index < m_model->rowCount();
+}
+
+QString CurrentSession::name() const
+{
+    if (!isValid())
+        return QString();
+    return m_model->data(m_model->index(m_index), SessionModel::NameRole).toString();
+}
+
+QString CurrentSession::fileName() const
+{
+    return m_model->get(m_index).fileName();
+}
+
+QString CurrentSession::comment() const
+{
+    return m_model->get(m_index).comment();
+}
+
+QString CurrentSession::exec() const
+{
+    return m_model->get(m_index).exec();
+}
+
+Session::Type CurrentSession::type() const
+{
+    return m_model->get(m_index).type();
+}
+
+void CurrentSession::selectNext()
+{
+    if (const int count = m_model->rowCount())
+        setIndex((m_index + 1) % count);
+}
+
+void CurrentSession::selectPrevious()
+{
+    if (const int count = m_model->rowCount())
+        setIndex((m_index + count - 1) % count);
+}
+
+void CurrentSession::modelReset()
+{
+    // The rows may all be different now, always notify. Keep the selected
+    // session selected, a session file added or removed before it moves its
+    // row.
+    if (!m_selectedFileName.isEmpty()) {
+        m_index = -1;
+        for (int i = 0; i < m_model->rowCount() && m_index < 0; ++i) {
+            const Session session = m_model->get(i);
+            if (session.fileName() == m_selectedFileName && session.type() == m_selectedType)
+                m_index = i;
+        }
+    }
+    if (!isValid())
+        m_index = m_model->rowCount() ? m_model->lastIndex() : -1;
+    Q_EMIT changed();
+}
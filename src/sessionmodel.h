@@ -11,15 +11,18 @@
 
 #include <QAbstractListModel>
 #include <QHash>
+#include <QQmlEngine>
 
+class CurrentSession;
 class SessionModelPrivate;
 
 class SessionModel : public QAbstractListModel
 {
     Q_OBJECT
     Q_DISABLE_COPY(SessionModel)
-    Q_PROPERTY(int lastIndex READ lastIndex CONSTANT)
-    Q_PROPERTY(int count READ rowCount CONSTANT)
+    Q_PROPERTY(int lastIndex READ lastIndex NOTIFY lastIndexChanged)
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+    Q_PROPERTY(CurrentSession *current READ current CONSTANT)
 
 public:
     enum SessionRole {
@@ -35,17 +38,76 @@ public:
     SessionModel(QObject *parent = 0);
     ~SessionModel();
 
+    // Reads the session files, the model is empty until then.
+    void load();
+    // Drops the sessions and stops watching the directories until load().
+    void clear();
+
     QHash<int, QByteArray> roleNames() const override;
 
     int lastIndex() const;
     Q_INVOKABLE void setLastIndex(int index);
-    Session *get(int indec);
+    Q_INVOKABLE Session get(int index) const;
+    CurrentSession *current() const;
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
+Q_SIGNALS:
+    void lastIndexChanged();
+    void countChanged();
+
 private:
     SessionModelPrivate *d{ nullptr };
+    CurrentSession *m_current{ nullptr };
 
+    void reload();
     void populate(Session::Type type, const QStringList &dirPaths);
 };
+
+// The selected row of a SessionModel as typed properties, starts at
+// lastIndex and is kept valid when the model is reloaded.
+class CurrentSession : public QObject
+{
+    Q_OBJECT
+    QML_ANONYMOUS
+    Q_PROPERTY(int index READ index WRITE setIndex NOTIFY changed FINAL)
+    Q_PROPERTY(bool valid READ isValid NOTIFY changed FINAL)
+    Q_PROPERTY(QString name READ name NOTIFY changed FINAL)
+    Q_PROPERTY(QString fileName READ fileName NOTIFY changed FINAL)
+    Q_PROPERTY(QString comment READ comment NOTIFY changed FINAL)
+    Q_PROPERTY(QString exec READ exec NOTIFY changed FINAL)
+    Q_PROPERTY(Session::Type type READ type NOTIFY changed FINAL)
+
+public:
+    explicit CurrentSession(SessionModel *model);
+
+    int index() const;
+    void setIndex(int index);
+    bool isValid() const;
+
+    // Disambiguated like SessionModel::NameRole.
+    QString name() const;
+    QString fileName() const;
+    QString comment() const;
+    QString exec() const;
+    Session::Type type() const;
+
+    // Wrap around at the ends, for themes cycling through sessions.
+    Q_INVOKABLE void selectNext();
+    Q_INVOKABLE void selectPrevious();
+
+Q_SIGNALS:
+    void changed();
+
+private:
+    void modelReset();
+
+    SessionModel *m_model;
+    int m_index{ -1 };
+    // Wayland and X11 sessions may share a file name.
+    QString m_selectedFileName;
+    Session::Type m_selectedType{ Session::UnknownSession };
+};
+
+Q_DECLARE_OPAQUE_POINTER(CurrentSession *)
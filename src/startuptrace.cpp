@@ -0,0 +1,66 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "startuptrace.h"
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(qLcStartup, "waygreet.startup")
+
+namespace StartupTrace {
+
+namespace {
+struct Stage
+{
+    QString name;
+    qint64 time;
+};
+
+bool s_enabled = false;
+bool s_finished = false;
+QElapsedTimer s_timer;
+QList<Stage> s_stages;
+} // namespace
+
+void setEnabled(bool enabled)
+{
+    s_enabled = enabled;
+}
+
+void mark(const QString &stage)
+{
+    if (s_finished)
+        return;
+
+    if (!s_timer.isValid())
+        s_timer.start();
+
+    const qint64 time = s_timer.nsecsElapsed();
+    s_stages.append({ stage, time });
+    qCDebug(qLcStartup).noquote() << stage << time / 1000000.0 << "ms";
+}
+
+void finish()
+{
+    if (s_finished)
+        return;
+    s_finished = true;
+
+    if (!s_enabled)
+        return;
+
+    qint64 previous = 0;
+    for (const auto &stage : std::as_const(s_stages)) {
+        qCInfo(qLcStartup).noquote()
+            << QStringLiteral("%1 ms (+%2 ms) %3")
+                   .arg(stage.time / 1000000.0, 8, 'f', 2)
+                   .arg((stage.time - previous) / 1000000.0, 7, 'f', 2)
+                   .arg(stage.name);
+        previous = stage.time;
+    }
+    s_stages.clear();
+}
+
+} // namespace StartupTrace
@@ -0,0 +1,17 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <QString>
+
+// Timestamps of the startup stages, relative to the first call of mark().
+// Printed by finish() with `waygreet --startup-trace`, logged to
+// waygreet.startup at debug level otherwise.
+namespace StartupTrace {
+
+void setEnabled(bool enabled);
+void mark(const QString &stage);
+void finish();
+
+} // namespace StartupTrace
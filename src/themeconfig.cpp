@@ -0,0 +1,115 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "themeconfig.h"
+
+#include <QColor>
+#include <QFile>
+#include <QFont>
+#include <QSettings>
+
+ThemeConfig::ThemeConfig(const QString &confPath, QObject *parent)
+    : QQmlPropertyMap(this, parent)
+    , m_path(confPath)
+{
+    reload();
+}
+
+QString ThemeConfig::path() const
+{
+    return m_path;
+}
+
+void ThemeConfig::reload()
+{
+    QHash<QString, QString> rawValues;
+
+    if (!m_path.isEmpty() && QFile::exists(m_path)) {
+        QSettings settings(m_path, QSettings::IniFormat);
+        // Qt's IniFormat maps [General] section keys to the top level —
+        // do NOT call beginGroup("General"), read childKeys() directly.
+        for (const QString &key : settings.childKeys()) {
+            const QVariant v = settings.value(key);
+            // Unquoted values containing ',' are split into a list by QSettings.
+            rawValues.insert(key,
+                             v.typeId() == QMetaType::QStringList
+                                 ? v.toStringList().join(QLatin1Char(','))
+                                 : v.toString());
+        }
+    }
+
+    for (const QString &key : keys()) {
+        if (!rawValues.contains(key))
+            clear(key);
+    }
+
+    // Parse once here, bindings then only read the typed value.
+    for (auto it = rawValues.cbegin(); it != rawValues.cend(); ++it) {
+        if (m_rawValues.value(it.key()) == it.value() && contains(it.key()))
+            continue;
+        insert(it.key(), parseValue(it.key(), it.value()));
+    }
+
+    m_rawValues = std::move(rawValues);
+}
+
+QVariant ThemeConfig::parseValue(const QString &key, const QString &value)
+{
+    const QString s = value.trimmed();
+    if (s.isEmpty())
+        return s;
+
+    const QString lower = s.toLower();
+    if (lower == QStringLiteral("true") || lower == QStringLiteral("yes"))
+        return true;
+    if (lower == QStringLiteral("false") || lower == QStringLiteral("no"))
+        return false;
+
+    bool ok = false;
+    const int i = s.toInt(&ok);
+    if (ok)
+        return i;
+    const qreal r = s.toDouble(&ok);
+    if (ok)
+        return r;
+
+    if (key.endsWith(QStringLiteral("font"), Qt::CaseInsensitive))
+        return QFont(s);
+
+    if (QColor::isValidColorName(s))
+        return QColor::fromString(s);
+
+    return s;
+}
+
+QString ThemeConfig::stringValue(const QString &key) const
+{
+    return m_rawValues.value(key);
+}
+
+bool ThemeConfig::boolValue(const QString &key) const
+{
+    const QVariant v = value(key);
+    switch (v.typeId()) {
+    case QMetaType::Bool:
+    case QMetaType::Int:
+    case QMetaType::Double:
+        return v.toBool();
+    default:
+        return false;
+    }
+}
+
+int ThemeConfig::intValue(const QString &key) const
+{
+    const QVariant v = value(key);
+    return v.typeId() == QMetaType::Double ? int(v.toDouble()) : v.toInt();
+}
+
+qreal ThemeConfig::realValue(const QString &key) const
+{
+    const QVariant v = value(key);
+    if (v.typeId() == QMetaType::Int || v.typeId() == QMetaType::Double)
+        return v.toReal();
+    return 0.0;
+}
@@ -0,0 +1,31 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <QHash>
+#include <QQmlPropertyMap>
+
+// Every key of theme.conf is exposed as a property of this map, already
+// converted to bool/int/real/color/font, so themes can bind `config.key`
+// directly. The *Value() helpers are kept for sddm style themes.
+class ThemeConfig : public QQmlPropertyMap
+{
+    Q_OBJECT
+public:
+    explicit ThemeConfig(const QString &confPath, QObject *parent = nullptr);
+
+    QString path() const;
+    void reload();
+
+    Q_INVOKABLE QString stringValue(const QString &key) const;
+    Q_INVOKABLE bool boolValue(const QString &key) const;
+    Q_INVOKABLE int intValue(const QString &key) const;
+    Q_INVOKABLE qreal realValue(const QString &key) const;
+
+private:
+    static QVariant parseValue(const QString &key, const QString &value);
+
+    QString m_path;
+    QHash<QString, QString> m_rawValues;
+};
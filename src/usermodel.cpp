@@ -4,15 +4,25 @@
 
 #include "usermodel.h"
 
+#include "accountsservice.h"
 #include "wayconfig.h"
 
+#include <QCoreApplication>
 #include <QFile>
 #include <QList>
+#include <QLoggingCategory>
+#include <QPointer>
 #include <QStringList>
 #include <QTextStream>
 
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <pwd.h>
+#include <thread>
+#include <utility>
+
+Q_LOGGING_CATEGORY(qLcUserModel, "waygreet.usermodel")
 
 #define ACCOUNTSSERVICE_DATA_DIR "/var/lib/AccountsService"
 
@@ -33,6 +43,25 @@ public:
     {
     }
 
+    // Placeholder while NSS is too slow to answer, only the name is known.
+    explicit User(const QString &name)
+        : name(name)
+        , needsPassword(true)
+    {
+    }
+
+    User(const AccountsServiceUser &data, const QString &defaultIcon)
+        : name(data.name)
+        , realName(data.realName)
+        , homeDir(data.homeDir)
+        , uid(int(data.uid))
+        , needsPassword(data.needsPassword)
+        , icon(!data.iconFile.isEmpty() && QFile::exists(data.iconFile)
+                   ? QStringLiteral("file://%1").arg(data.iconFile)
+                   : defaultIcon)
+    {
+    }
+
     QString name;
     QString realName;
     QString homeDir;
@@ -44,17 +73,81 @@ public:
 
 typedef std::shared_ptr<User> UserPtr;
 
+namespace {
+struct Enumeration
+{
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done{ false };
+    // load() gave up waiting, the result is delivered through the event loop.
+    bool timedOut{ false };
+    // clear() dropped the model's users, the result is discarded. Only
+    // written on the GUI thread.
+    bool cancelled{ false };
+    QList<UserPtr> users;
+};
+} // namespace
+
 class UserModelPrivate
 {
 public:
     int lastIndex{ 0 };
     QList<UserPtr> users;
     bool containsAllUsers{ true };
+    bool needAllUsers{ true };
+    AccountsService *accounts{ nullptr };
+    // The detached enumeration whose result is still awaited, at most one
+    // runs at a time.
+    std::shared_ptr<Enumeration> enumeration;
 };
 
+// Filled by preload() in the zygote, taken by the first load() of a greeter.
+static QList<UserPtr> preloadedUsers;
+
+// Whether detached enumerations may still post to the application. Cleared
+// by a post routine of its destructor, under the mutex they post with.
+static std::mutex applicationMutex;
+static bool applicationAlive = false;
+
+static void watchApplication()
+{
+    std::lock_guard lock(applicationMutex);
+    if (applicationAlive)
+        return;
+    applicationAlive = true;
+    qAddPostRoutine([] {
+        std::lock_guard lock(applicationMutex);
+        applicationAlive = false;
+    });
+}
+
+static bool byName(const UserPtr &u1, const UserPtr &u2)
+{
+    return u1->name < u2->name;
+}
+
 UserModel::UserModel(bool needAllUsers, QObject *parent)
     : QAbstractListModel(parent)
     , d(new UserModelPrivate())
+{
+    d->needAllUsers = needAllUsers;
+    m_current = new CurrentUser(this);
+}
+
+namespace {
+// Read on the GUI thread, QSettings must not be used from the enumeration thread.
+struct EnumerationOptions
+{
+    int minimumUid;
+    int maximumUid;
+    QStringList hideUsers;
+    QString lastUser;
+    bool needAllUsers;
+};
+
+} // namespace
+
+static QString defaultIcon()
 {
     const QString facesDir = "/usr/share/faces";  // mainConfig.Theme.FacesDir.get();
     const QString themeDir = "/usr/share/themes"; // mainConfig.Theme.ThemeDir.get();
@@ -62,9 +155,40 @@ UserModel::UserModel(bool needAllUsers, QObject *parent)
     const QString themeDefaultFace =
         QStringLiteral("%1/%2/faces/.face.icon").arg(themeDir).arg(currentTheme);
     const QString defaultFace = QStringLiteral("%1/.face.icon").arg(facesDir);
-    const QString iconURI =
-        QStringLiteral("file://%1")
-            .arg(QFile::exists(themeDefaultFace) ? themeDefaultFace : defaultFace);
+    return QStringLiteral("file://%1")
+        .arg(QFile::exists(themeDefaultFace) ? themeDefaultFace : defaultFace);
+}
+
+// Same filter as enumerateUsers() applies to passwd entries.
+static bool isShown(const AccountsServiceUser &user)
+{
+    const auto config = WayConfig::instance();
+    return !user.systemAccount && !user.name.isEmpty()
+        && int(user.uid) >= config->minimumUid() && int(user.uid) <= config->maximumUid()
+        && !config->hideUsers().contains(user.name);
+}
+
+static QList<UserPtr> lastUserPlaceholder()
+{
+    // Built without NSS, which is what hangs. The name is enough to log in.
+    QList<UserPtr> users;
+    const QString lastUser = WayConfig::instance()->lastUser();
+    if (!lastUser.isEmpty())
+        users << UserPtr(new User(lastUser));
+    return users;
+}
+
+// May block for as long as NSS does, e.g. on an unreachable LDAP server.
+static QList<UserPtr> enumerateUsers(const EnumerationOptions &options)
+{
+    QList<UserPtr> users;
+
+    const QString facesDir = "/usr/share/faces";  // mainConfig.Theme.FacesDir.get();
+    const QString themeDir = "/usr/share/themes"; // mainConfig.Theme.ThemeDir.get();
+    const QString currentTheme = "";              // mainConfig.Theme.Current.get();
+    const QString themeDefaultFace =
+        QStringLiteral("%1/%2/faces/.face.icon").arg(themeDir).arg(currentTheme);
+    const QString iconURI = defaultIcon();
 
     bool lastUserFound = false;
 
@@ -73,36 +197,33 @@ UserModel::UserModel(bool needAllUsers, QObject *parent)
     while ((current_pw = getpwent()) != nullptr) {
 
         // skip entries with uids smaller than minimum uid
-        if (int(current_pw->pw_uid) < WayConfig::instance()->minimumUid())
+        if (int(current_pw->pw_uid) < options.minimumUid)
             continue;
 
         // skip entries with uids greater than maximum uid
-        if (int(current_pw->pw_uid) > WayConfig::instance()->maximumUid())
+        if (int(current_pw->pw_uid) > options.maximumUid)
             continue;
 
         // skip entries with user names in the hide users list
-        if (WayConfig::instance()->hideUsers().contains(
-                QString::fromLocal8Bit(current_pw->pw_name)))
+        if (options.hideUsers.contains(QString::fromLocal8Bit(current_pw->pw_name)))
             continue;
 
         // create user
         UserPtr user{ new User(current_pw, iconURI) };
 
         // add user
-        d->users << user;
+        users << user;
 
-        if (user->name == WayConfig::instance()->lastUser())
+        if (user->name == options.lastUser)
             lastUserFound = true;
 
-        if (!needAllUsers) {
+        if (!options.needAllUsers) {
             struct passwd *lastUserData;
             // If the theme doesn't require that all users are present, try to add the data for
             // lastUser at least
-            if (!lastUserFound
-                && (lastUserData = getpwnam(qPrintable(WayConfig::instance()->lastUser()))))
-                d->users << UserPtr(new User(lastUserData, themeDefaultFace));
+            if (!lastUserFound && (lastUserData = getpwnam(qPrintable(options.lastUser))))
+                users << UserPtr(new User(lastUserData, themeDefaultFace));
 
-            d->containsAllUsers = false;
             break;
         }
     }
@@ -110,25 +231,18 @@ UserModel::UserModel(bool needAllUsers, QObject *parent)
     endpwent();
 
     // sort users by username
-    std::sort(d->users.begin(), d->users.end(), [&](const UserPtr &u1, const UserPtr &u2) {
-        return u1->name < u2->name;
-    });
+    std::sort(users.begin(), users.end(), byName);
     // Remove duplicates in case we have several sources specified
     // in nsswitch.conf(5).
     auto newEnd =
-        std::unique(d->users.begin(), d->users.end(), [&](const UserPtr &u1, const UserPtr &u2) {
+        std::unique(users.begin(), users.end(), [&](const UserPtr &u1, const UserPtr &u2) {
             return u1->name == u2->name;
         });
-    d->users.erase(newEnd, d->users.end());
+    users.erase(newEnd, users.end());
 
     bool avatarsEnabled = true;
 
-    // find out index of the last user
-    for (int i = 0; i < d->users.size(); ++i) {
-        UserPtr user{ d->users.at(i) };
-        if (user->name == WayConfig::instance()->lastUser())
-            d->lastIndex = i;
-
+    for (const auto &user : std::as_const(users)) {
         if (avatarsEnabled) {
             const QString userFace = QStringLiteral("%1/.face.icon").arg(user->homeDir);
             const QString systemFace =
@@ -150,6 +264,245 @@ UserModel::UserModel(bool needAllUsers, QObject *parent)
                 user->icon = QStringLiteral("file://%1").arg(userIcon);
         }
     }
+
+    return users;
+}
+
+void UserModel::preload()
+{
+    const auto config = WayConfig::instance();
+    preloadedUsers = enumerateUsers({ config->minimumUid(), config->maximumUid(),
+                                      config->hideUsers(), config->lastUser(), true });
+}
+
+void UserModel::load()
+{
+    if (WayConfig::instance()->userBackend() == QStringLiteral("accountsservice"))
+        loadAccountsService();
+    else
+        loadPasswd();
+}
+
+void UserModel::loadAccountsService()
+{
+    d->accounts = new AccountsService(AccountsService::configuredBus(), this);
+
+    connect(d->accounts, &AccountsService::loaded, this, [this] {
+        const QString icon = defaultIcon();
+        QList<UserPtr> users;
+        for (const auto &user : d->accounts->users()) {
+            if (isShown(user))
+                users << UserPtr(new User(user, icon));
+        }
+        std::sort(users.begin(), users.end(), byName);
+        setUsers(users, true);
+    });
+    connect(d->accounts, &AccountsService::failed, this, [this] {
+        qCWarning(qLcUserModel) << "AccountsService unavailable, enumerating passwd instead";
+        d->accounts->deleteLater();
+        d->accounts = nullptr;
+        loadPasswd();
+    });
+    connect(d->accounts, &AccountsService::userAdded, this, [this](const AccountsServiceUser &user) {
+        if (isShown(user))
+            insertUser(UserPtr(new User(user, defaultIcon())));
+    });
+    connect(d->accounts,
+            &AccountsService::userRemoved,
+            this,
+            [this](const AccountsServiceUser &user) {
+                removeUser(user.name);
+            });
+    connect(d->accounts,
+            &AccountsService::userChanged,
+            this,
+            [this](const AccountsServiceUser &previous, const AccountsServiceUser &user) {
+                const bool shown = isShown(user);
+                if (previous.name != user.name || !shown)
+                    removeUser(previous.name);
+                if (shown)
+                    insertUser(UserPtr(new User(user, defaultIcon())));
+            });
+
+    // Until the service answers, the last user is enough to log in.
+    setUsers(lastUserPlaceholder(), false);
+    d->accounts->load();
+}
+
+void UserModel::loadPasswd()
+{
+    const auto config = WayConfig::instance();
+    const EnumerationOptions options{ config->minimumUid(), config->maximumUid(),
+                                      config->hideUsers(),  config->lastUser(),
+                                      d->needAllUsers };
+    const int timeout = config->userEnumerationTimeout();
+
+    // Still stuck in NSS since before clear(), e.g. after a failed login.
+    // Its result is taken instead of starting a second getpwent() next to it.
+    if (d->enumeration) {
+        std::unique_lock lock(d->enumeration->mutex);
+        if (!d->enumeration->done) {
+            d->enumeration->cancelled = false;
+            d->enumeration->timedOut = true;
+            lock.unlock();
+            setUsers(lastUserPlaceholder(), false);
+            return;
+        }
+        lock.unlock();
+        d->enumeration.reset();
+    }
+
+    // Inherited from the zygote, possibly from before the last login. Shown at
+    // once and refreshed by the enumeration below.
+    const bool preloaded = d->needAllUsers && !preloadedUsers.isEmpty();
+    if (preloaded)
+        setUsers(std::exchange(preloadedUsers, {}), true);
+
+    if (timeout <= 0 && !preloaded) {
+        setUsers(enumerateUsers(options), d->needAllUsers);
+        return;
+    }
+
+    // Detached, a hanging NSS call can't be interrupted and must not block exit.
+    watchApplication();
+    auto enumeration = std::make_shared<Enumeration>();
+    enumeration->timedOut = preloaded;
+    d->enumeration = enumeration;
+    QPointer<UserModel> model(this);
+    std::thread([enumeration, options, model] {
+        auto users = enumerateUsers(options);
+
+        std::unique_lock lock(enumeration->mutex);
+        enumeration->done = true;
+        enumeration->users = users;
+        enumeration->finished.notify_one();
+        if (!enumeration->timedOut || enumeration->cancelled)
+            return;
+        lock.unlock();
+
+        qCInfo(qLcUserModel) << "Enumerated" << users.size() << "users in the background";
+        // Held while posting, the application can't be destroyed in between.
+        std::lock_guard appLock(applicationMutex);
+        if (applicationAlive) {
+            QMetaObject::invokeMethod(
+                QCoreApplication::instance(),
+                [users, model, enumeration, needAllUsers = options.needAllUsers] {
+                    // Cleared in the meantime, possibly loaded again since.
+                    if (!model || model->d->enumeration != enumeration || enumeration->cancelled)
+                        return;
+                    model->d->enumeration.reset();
+                    model->setUsers(users, needAllUsers);
+                },
+                Qt::QueuedConnection);
+        }
+    }).detach();
+
+    if (preloaded)
+        return;
+
+    std::unique_lock lock(enumeration->mutex);
+    if (enumeration->finished.wait_for(lock, std::chrono::milliseconds(timeout), [&enumeration] {
+            return enumeration->done;
+        })) {
+        d->enumeration.reset();
+        setUsers(enumeration->users, d->needAllUsers);
+        return;
+    }
+    enumeration->timedOut = true;
+    lock.unlock();
+
+    qCWarning(qLcUserModel) << "Enumerating users took longer than" << timeout
+                            << "ms, showing the last user until it finishes";
+    setUsers(lastUserPlaceholder(), false);
+}
+
+void UserModel::setUsers(const QList<UserPtr> &users, bool containsAllUsers)
+{
+    beginResetModel();
+    d->users = users;
+    d->containsAllUsers = containsAllUsers;
+
+    updateLastIndex();
+
+    endResetModel();
+    Q_EMIT countChanged();
+    Q_EMIT lastIndexChanged();
+    Q_EMIT containsAllUsersChanged();
+}
+
+void UserModel::insertUser(const UserPtr &user)
+{
+    auto it = std::lower_bound(d->users.begin(), d->users.end(), user, byName);
+    const int row = it - d->users.begin();
+    const int lastIndex = d->lastIndex;
+
+    // Replaces the placeholder of the last user or an outdated entry.
+    if (it != d->users.end() && (*it)->name == user->name) {
+        *it = user;
+        Q_EMIT dataChanged(index(row), index(row));
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), row, row);
+    d->users.insert(row, user);
+    updateLastIndex();
+    endInsertRows();
+
+    Q_EMIT countChanged();
+    if (d->lastIndex != lastIndex)
+        Q_EMIT lastIndexChanged();
+}
+
+void UserModel::removeUser(const QString &name)
+{
+    int row = -1;
+    for (int i = 0; i < d->users.size() && row < 0; ++i) {
+        if (d->users.at(i)->name == name)
+            row = i;
+    }
+    if (row < 0)
+        return;
+
+    const int lastIndex = d->lastIndex;
+    beginRemoveRows(QModelIndex(), row, row);
+    d->users.removeAt(row);
+    updateLastIndex();
+    endRemoveRows();
+
+    Q_EMIT countChanged();
+    if (d->lastIndex != lastIndex)
+        Q_EMIT lastIndexChanged();
+}
+
+void UserModel::updateLastIndex()
+{
+    // find out index of the last user
+    d->lastIndex = 0;
+    const QString lastUser = WayConfig::instance()->lastUser();
+    for (int i = 0; i < d->users.size(); ++i) {
+        if (d->users.at(i)->name == lastUser)
+            d->lastIndex = i;
+    }
+}
+
+void UserModel::clear()
+{
+    if (d->accounts) {
+        // Its queued signals must not refill the model.
+        d->accounts->disconnect(this);
+        d->accounts->deleteLater();
+        d->accounts = nullptr;
+    }
+    // A hanging enumeration keeps running, load() picks it up again.
+    if (d->enumeration) {
+        std::unique_lock lock(d->enumeration->mutex);
+        d->enumeration->cancelled = true;
+        if (d->enumeration->done) {
+            lock.unlock();
+            d->enumeration.reset();
+        }
+    }
+    setUsers({}, false);
 }
 
 UserModel::~UserModel()
@@ -208,3 +561,133 @@ bool UserModel::containsAllUsers() const
 {
     return d->containsAllUsers;
 }
+
+CurrentUser *UserModel::current() const
+{
+    return m_current;
+}
+
+CurrentUser::CurrentUser(UserModel *model)
+    : QObject(model)
+    , m_model(model)
+{
+    // Kept while the model is empty, e.g. cleared until a failed login
+    // reloads it, so the user who just tried stays selected.
+    connect(model, &QAbstractItemModel::modelAboutToBeReset, this, [this] {
+        if (isValid())
+            m_selectedName = name();
+    });
+    connect(model, &QAbstractItemModel::modelReset, this, &CurrentUser::modelReset);
+    connect(model, &QAbstractItemModel::rowsInserted, this, &CurrentUser::rowsInserted);
+    connect(model, &QAbstractItemModel::rowsRemoved, this, &CurrentUser::rowsRemoved);
+    connect(model,
+            &QAbstractItemModel::dataChanged,
+            this,
+            [this](const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+                if (m_index >= topLeft.row() && m_index <= bottomRight.row())
+                    Q_EMIT changed();
+            });
+}
+
+int CurrentUser::index() const
+{
+    return m_index;
+}
+
+void CurrentUser::setIndex(int index)
+{
+    if (index < 0 || index >= m_model->rowCount() || index == m_index)
+        return;
+
+    m_index = index;
+    Q_EMIT changed();
+}
+
+bool CurrentUser::isValid() const
+{
+    return m_index >= 0 && m_index < m_model->rowCount();
+}
+
+QString CurrentUser::name() const
+{
+    return value(UserModel::NameRole).toString();
+}
+
+QString CurrentUser::realName() const
+{
+    return value(UserModel::RealNameRole).toString();
+}
+
+QString CurrentUser::homeDir() const
+{
+    return value(UserModel::HomeDirRole).toString();
+}
+
+QString CurrentUser::icon() const
+{
+    return value(UserModel::IconRole).toString();
+}
+
+bool CurrentUser::needsPassword() const
+{
+    return value(UserModel::NeedsPasswordRole).toBool();
+}
+
+void CurrentUser::selectNext()
+{
+    if (const int count = m_model->rowCount())
+        setIndex((m_index + 1) % count);
+}
+
+void CurrentUser::selectPrevious()
+{
+    if (const int count = m_model->rowCount())
+        setIndex((m_index + count - 1) % count);
+}
+
+QVariant CurrentUser::value(int role) const
+{
+    if (!isValid())
+        return QVariant();
+    return m_model->data(m_model->index(m_index), role);
+}
+
+void CurrentUser::modelReset()
+{
+    // The rows may all be different now, always notify. Keep the selected user
+    // selected, e.g. when the full list replaces the one shown after a timeout.
+    if (!m_selectedName.isEmpty()) {
+        m_index = -1;
+        for (int i = 0; i < m_model->rowCount(); ++i) {
+            if (m_model->data(m_model->index(i), UserModel::NameRole) == m_selectedName)
+                m_index = i;
+        }
+    }
+    if (!isValid())
+        m_index = m_model->rowCount() ? m_model->lastIndex() : -1;
+    Q_EMIT changed();
+}
+
+void CurrentUser::rowsInserted(const QModelIndex &, int first, int last)
+{
+    if (m_index < 0) {
+        // Picks the previously selected user or the last one.
+        modelReset();
+        return;
+    }
+    if (m_index < first)
+        return;
+    m_index += last - first + 1;
+    Q_EMIT changed();
+}
+
+void CurrentUser::rowsRemoved(const QModelIndex &, int first, int last)
+{
+    if (m_index > last)
+        m_index -= last - first + 1;
+    else if (m_index >= first)
+        m_index = m_model->rowCount() ? m_model->lastIndex() : -1;
+    else
+        return;
+    Q_EMIT changed();
+}
@@ -8,16 +8,22 @@
 
 #include <QAbstractListModel>
 #include <QHash>
+#include <QQmlEngine>
 
+#include <memory>
+
+class CurrentUser;
+class User;
 class UserModelPrivate;
 
 class UserModel : public QAbstractListModel
 {
     Q_OBJECT
     Q_DISABLE_COPY(UserModel)
-    Q_PROPERTY(int lastIndex READ lastIndex CONSTANT)
-    Q_PROPERTY(int count READ rowCount CONSTANT)
-    Q_PROPERTY(bool containsAllUsers READ containsAllUsers CONSTANT)
+    Q_PROPERTY(int lastIndex READ lastIndex NOTIFY lastIndexChanged)
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+    Q_PROPERTY(bool containsAllUsers READ containsAllUsers NOTIFY containsAllUsersChanged)
+    Q_PROPERTY(CurrentUser *current READ current CONSTANT)
 public:
     enum UserRoles {
         NameRole = Qt::UserRole + 1,
@@ -31,6 +37,20 @@ public:
     UserModel(bool needAllUsers, QObject *parent = 0);
     ~UserModel();
 
+    // Enumerates the users, the model is empty until then. With the
+    // AccountsService backend it returns at once and keeps following the
+    // service. Otherwise it waits at most
+    // WayConfig::userEnumerationTimeout() ms, if NSS is slower only the last
+    // user is shown and the rest arrive when the enumeration finishes.
+    void load();
+    // Drops the users and stops following AccountsService until load(). A
+    // running enumeration's result is discarded, the current user's name is
+    // kept to select it again.
+    void clear();
+    // Enumerates all users in advance, used by the first load() with the
+    // passwd backend that needs all users.
+    static void preload();
+
     QHash<int, QByteArray> roleNames() const override;
 
     int lastIndex() const;
@@ -39,7 +59,69 @@ public:
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
     bool containsAllUsers() const;
+    CurrentUser *current() const;
+
+Q_SIGNALS:
+    void lastIndexChanged();
+    void countChanged();
+    void containsAllUsersChanged();
 
 private:
+    void loadPasswd();
+    void loadAccountsService();
+    void setUsers(const QList<std::shared_ptr<User>> &users, bool containsAllUsers);
+    // Incremental changes from AccountsService, rows stay sorted by name.
+    void insertUser(const std::shared_ptr<User> &user);
+    void removeUser(const QString &name);
+    void updateLastIndex();
+
     UserModelPrivate *d{ nullptr };
+    CurrentUser *m_current{ nullptr };
+};
+
+// The selected row of a UserModel as typed properties, starts at lastIndex
+// and is kept valid when the model is reloaded.
+class CurrentUser : public QObject
+{
+    Q_OBJECT
+    QML_ANONYMOUS
+    Q_PROPERTY(int index READ index WRITE setIndex NOTIFY changed FINAL)
+    Q_PROPERTY(bool valid READ isValid NOTIFY changed FINAL)
+    Q_PROPERTY(QString name READ name NOTIFY changed FINAL)
+    Q_PROPERTY(QString realName READ realName NOTIFY changed FINAL)
+    Q_PROPERTY(QString homeDir READ homeDir NOTIFY changed FINAL)
+    Q_PROPERTY(QString icon READ icon NOTIFY changed FINAL)
+    Q_PROPERTY(bool needsPassword READ needsPassword NOTIFY changed FINAL)
+
+public:
+    explicit CurrentUser(UserModel *model);
+
+    int index() const;
+    void setIndex(int index);
+    bool isValid() const;
+
+    QString name() const;
+    QString realName() const;
+    QString homeDir() const;
+    QString icon() const;
+    bool needsPassword() const;
+
+    // Wrap around at the ends, for themes cycling through users.
+    Q_INVOKABLE void selectNext();
+    Q_INVOKABLE void selectPrevious();
+
+Q_SIGNALS:
+    void changed();
+
+private:
+    QVariant value(int role) const;
+    void modelReset();
+    void rowsInserted(const QModelIndex &parent, int first, int last);
+    void rowsRemoved(const QModelIndex &parent, int first, int last);
+
+    UserModel *m_model;
+    int m_index{ -1 };
+    QString m_selectedName;
 };
+
+Q_DECLARE_OPAQUE_POINTER(CurrentUser *)
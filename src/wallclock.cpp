@@ -0,0 +1,35 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "wallclock.h"
+
+WallClock::WallClock(QObject *parent)
+    : QObject(parent)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &WallClock::tick);
+
+    tick();
+}
+
+QDateTime WallClock::currentTime() const
+{
+    return m_currentTime;
+}
+
+void WallClock::tick()
+{
+    const auto now = QDateTime::currentDateTime();
+    auto minute = now;
+    minute.setTime(QTime(now.time().hour(), now.time().minute()));
+
+    if (minute != m_currentTime) {
+        m_currentTime = minute;
+        Q_EMIT minuteChanged();
+    }
+
+    // Re-armed from the wall clock every time, so suspend or a clock change
+    // only delays the next update until the following minute at most.
+    m_timer.start(int(now.msecsTo(minute.addSecs(60))) + 1);
+}
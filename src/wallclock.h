@@ -0,0 +1,34 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <QDateTime>
+#include <QObject>
+#include <QQmlEngine>
+#include <QTimer>
+
+// Time source for clocks in the greeter, only ticks on minute boundaries so
+// an idle login screen doesn't need to render anything in between.
+class WallClock : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_SINGLETON
+
+    Q_PROPERTY(QDateTime currentTime READ currentTime NOTIFY minuteChanged)
+
+public:
+    explicit WallClock(QObject *parent = nullptr);
+
+    QDateTime currentTime() const;
+
+Q_SIGNALS:
+    void minuteChanged();
+
+private:
+    void tick();
+
+    QTimer m_timer;
+    QDateTime m_currentTime;
+};
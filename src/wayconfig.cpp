@@ -15,6 +15,12 @@ WayConfig::WayConfig(QObject *parent)
     m_instance = this;
 }
 
+WayConfig::~WayConfig()
+{
+    Q_ASSERT(m_instance == this);
+    m_instance = nullptr;
+}
+
 WayConfig * ::WayConfig::instance()
 {
     return m_instance;
@@ -28,6 +34,48 @@ QUrl WayConfig::background() const
     return QUrl::fromLocalFile(path);
 }
 
+bool WayConfig::damageTracking() const
+{
+    return m_config->value("damageTracking", true).toBool();
+}
+
+bool WayConfig::greeterFollowsCursor() const
+{
+    return m_config->value("greeterFollowsCursor", false).toBool();
+}
+
+int WayConfig::idleTimeout() const
+{
+    // Seconds without input before the outputs are turned off, 0 disables it.
+    return m_config->value("idleTimeout", 0).toInt();
+}
+
+int WayConfig::frameStatsDumpInterval() const
+{
+    // Seconds between frame statistics dumps to the log, 0 disables it.
+    return m_config->value("frameStatsDumpInterval", 0).toInt();
+}
+
+bool WayConfig::directScanoutMirror() const
+{
+    return m_config->value("directScanoutMirror", true).toBool();
+}
+
+bool WayConfig::fastExit() const
+{
+    return m_config->value("fastExit", true).toBool();
+}
+
+bool WayConfig::trimMemory() const
+{
+    return m_config->value("trimMemory", true).toBool();
+}
+
+void WayConfig::sync()
+{
+    m_config->sync();
+}
+
 QString WayConfig::cursorTheme() const
 {
     return m_config->value("cursorTheme", "default").toString();
@@ -68,13 +116,54 @@ QString WayConfig::themeDir() const
     return dir;
 }
 
+QStringList WayConfig::preloadThemes() const
+{
+    m_config->beginGroup("Theme");
+    auto themes = m_config->value("preload").toString().split(";", Qt::SkipEmptyParts);
+    m_config->endGroup();
+    return themes;
+}
+
+int WayConfig::themeCacheLimit() const
+{
+    m_config->beginGroup("Theme");
+    auto limit = m_config->value("cacheLimit", 4).toInt();
+    m_config->endGroup();
+    return limit;
+}
+
+int WayConfig::backgroundCacheLimit() const
+{
+    // MiB of scaled and blurred backgrounds kept in the cache directory.
+    m_config->beginGroup("Theme");
+    auto limit = m_config->value("backgroundCacheLimit", 64).toInt();
+    m_config->endGroup();
+    return limit;
+}
+
 bool WayConfig::showX11Session() const
 {
+    if (m_showX11SessionOverride)
+        return *m_showX11SessionOverride;
+
     return m_config->value("showX11Session", false).toBool();
 }
 
+void WayConfig::setShowX11SessionOverride(bool show)
+{
+    m_showX11SessionOverride = show;
+}
+
+void WayConfig::setSessionDirOverride(const QString &dir)
+{
+    m_sessionDirOverride = dir;
+}
+
 QStringList WayConfig::waylandSessionDir() const
 {
+    if (!m_sessionDirOverride.isEmpty())
+        return { m_sessionDirOverride };
+
     QStringList sessionDir;
     if (auto path = m_config->value("waylandSessionDir").toString(); !path.isEmpty())
         sessionDir << path;
@@ -85,6 +174,9 @@ QStringList WayConfig::waylandSessionDir() const
 
 QStringList WayConfig::x11SessionDir() const
 {
+    if (!m_sessionDirOverride.isEmpty())
+        return { m_sessionDirOverride };
+
     QStringList sessionDir;
     if (auto path = m_config->value("x11SessionDir").toString(); !path.isEmpty())
         sessionDir << path;
@@ -129,6 +221,24 @@ QStringList WayConfig::hideUsers() const
     return m_config->value("hideUsers").toString().split(";");
 }
 
+int WayConfig::userEnumerationTimeout() const
+{
+    // Milliseconds UserModel::load() blocks on NSS, 0 waits until it's done.
+    return m_config->value("userEnumerationTimeout", 3000).toInt();
+}
+
+QString WayConfig::userBackend() const
+{
+    // "passwd" or "accountsservice".
+    return m_config->value("userBackend", "passwd").toString();
+}
+
+QString WayConfig::accountsServiceBus() const
+{
+    // "system", "session" or a D-Bus address, e.g. of a stand-in service.
+    return m_config->value("accountsServiceBus", "system").toString();
+}
+
 QString WayConfig::powerOffCommand() const
 {
     return QStringLiteral("/usr/bin/systemctl poweroff");
@@ -8,6 +8,8 @@
 #include <QSettings>
 #include <QSize>
 
+#include <optional>
+
 class WayConfig : public QObject
 {
     Q_OBJECT
@@ -20,18 +22,36 @@ class WayConfig : public QObject
 
 public:
     explicit WayConfig(QObject *parent = nullptr);
+    ~WayConfig() override;
     static WayConfig *instance();
 
+    // Writes pending changes, needed before exiting without destructors.
+    void sync();
+
     QUrl background() const;
 
+    bool damageTracking() const;
+    bool greeterFollowsCursor() const;
+    int idleTimeout() const;
+    int frameStatsDumpInterval() const;
+    bool directScanoutMirror() const;
+    bool fastExit() const;
+    bool trimMemory() const;
+
     QString cursorTheme() const;
     QSize cursorSize() const;
 
     QString theme() const;
     void setThemeOverride(const QString &theme);
     QString themeDir() const;
+    QStringList preloadThemes() const;
+    int themeCacheLimit() const;
+    int backgroundCacheLimit() const;
 
     bool showX11Session() const;
+    void setShowX11SessionOverride(bool show);
+    // Replaces both session directories, e.g. for benchmarks.
+    void setSessionDirOverride(const QString &dir);
     QStringList waylandSessionDir() const;
     QStringList x11SessionDir() const;
 
@@ -44,6 +64,9 @@ public:
     int minimumUid() const;
     int maximumUid() const;
     QStringList hideUsers() const;
+    int userEnumerationTimeout() const;
+    QString userBackend() const;
+    QString accountsServiceBus() const;
 
     QString powerOffCommand() const;
     QString rebootCommand() const;
@@ -53,4 +76,6 @@ private:
 
     inline static WayConfig *m_instance = nullptr;
     QString m_themeOverride;
+    QString m_sessionDirOverride;
+    std::optional<bool> m_showX11SessionOverride;
 };
@@ -0,0 +1,408 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "zygote.h"
+
+#include "qmlengine.h"
+#include "startuptrace.h"
+#include "usermodel.h"
+#include "wayconfig.h"
+
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QLoggingCategory>
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <thread>
+
+#include <poll.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+Q_LOGGING_CATEGORY(qLcZygote, "waygreet.zygote")
+
+extern char **environ;
+
+namespace {
+
+// stdin, stdout and stderr of the connecting process.
+constexpr int StdioCount = 3;
+// Far more than greetd passes, a larger request is rejected unread.
+constexpr quint32 MaxEnvironmentSize = 64 * 1024;
+
+// From linux/ioprio.h, IOPRIO_CLASS_IDLE for the calling thread.
+constexpr int IoprioWhoProcess = 1;
+constexpr int IoprioIdle = 3 << 13;
+
+bool writeFully(int fd, const void *data, size_t size)
+{
+    auto bytes = static_cast<const char *>(data);
+    while (size > 0) {
+        const ssize_t n = write(fd, bytes, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        bytes += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool readFully(int fd, void *data, size_t size)
+{
+    auto bytes = static_cast<char *>(data);
+    while (size > 0) {
+        const ssize_t n = read(fd, bytes, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        bytes += n;
+        size -= n;
+    }
+    return true;
+}
+
+sockaddr_un socketAddress(const QString &path)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    const QByteArray encoded = QFile::encodeName(path);
+    strncpy(address.sun_path, encoded.constData(), sizeof(address.sun_path) - 1);
+    return address;
+}
+
+void warmFile(const QString &path)
+{
+    // Only to get it into the page cache.
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    while (!file.read(64 * 1024).isEmpty()) { }
+}
+
+void warmDirectory(const QString &dir)
+{
+    QDirIterator it(dir, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext())
+        warmFile(it.next());
+}
+
+void warmCaches()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const auto config = WayConfig::instance();
+    // Picks up changes made since the last greeter.
+    config->sync();
+    QStringList themes = config->preloadThemes();
+    themes.prepend(config->theme());
+    for (const auto &theme : std::as_const(themes)) {
+        const QString path = QmlEngine::themePath(theme);
+        if (!path.isEmpty())
+            warmDirectory(QFileInfo(path).absolutePath());
+    }
+    warmFile(config->background().toLocalFile());
+
+    const QStringList sessionDirs = config->waylandSessionDir() + config->x11SessionDir();
+    for (const auto &dir : sessionDirs)
+        warmDirectory(dir);
+
+    UserModel::preload();
+
+    qCInfo(qLcZygote) << "Caches warmed in" << timer.elapsed() << "ms";
+}
+
+// At idle CPU and I/O priority, the session the last greeter started comes
+// first. Only the thread's priority is lowered, forked greeters don't
+// inherit it.
+void warmCachesAtIdlePriority()
+{
+    std::thread([] {
+        setpriority(PRIO_PROCESS, int(syscall(SYS_gettid)), 19);
+        syscall(SYS_ioprio_set, IoprioWhoProcess, 0, IoprioIdle);
+        warmCaches();
+    }).join();
+}
+
+// Only the greeter user may reach the socket, nobody else can replace it.
+bool prepareSocketDirectory(const QString &socketPath)
+{
+    const QByteArray dir = QFile::encodeName(QFileInfo(socketPath).absolutePath());
+    if (mkdir(dir.constData(), 0700) < 0 && errno != EEXIST) {
+        qCCritical(qLcZygote) << "Can't create" << dir << strerror(errno);
+        return false;
+    }
+
+    struct stat info;
+    if (lstat(dir.constData(), &info) < 0 || !S_ISDIR(info.st_mode)
+        || info.st_uid != getuid() || (info.st_mode & 077)) {
+        qCCritical(qLcZygote) << "The socket directory" << dir
+                              << "must be a 0700 directory owned by the greeter user";
+        return false;
+    }
+    return true;
+}
+
+bool isGreeterUser(int socket)
+{
+    ucred credentials{};
+    socklen_t size = sizeof(credentials);
+    if (getsockopt(socket, SOL_SOCKET, SO_PEERCRED, &credentials, &size) < 0)
+        return false;
+    return credentials.uid == getuid();
+}
+
+// Only these come from the connecting process, the rest of the environment
+// is the zygote's own.
+bool isForwardedVariable(const QByteArray &name)
+{
+    return name == "GREETD_SOCK" || name == "SEATD_SOCK" || name == "LIBSEAT_BACKEND"
+        || name.startsWith("XDG_") || name.startsWith("WAYLAND_");
+}
+
+// The environment is sent after the fds, prefixed with its size.
+bool receiveRequest(int socket, int fds[StdioCount], QByteArray *environment)
+{
+    quint32 size = 0;
+    iovec iov{ &size, sizeof(size) };
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * StdioCount)];
+    msghdr message{};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    ssize_t n;
+    do {
+        n = recvmsg(socket, &message, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+    if (n != sizeof(size))
+        return false;
+
+    cmsghdr *header = CMSG_FIRSTHDR(&message);
+    if (!header || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS
+        || header->cmsg_len != CMSG_LEN(sizeof(int) * StdioCount))
+        return false;
+    memcpy(fds, CMSG_DATA(header), sizeof(int) * StdioCount);
+
+    if (size > MaxEnvironmentSize) {
+        qCWarning(qLcZygote) << "Environment of" << size << "bytes is too large";
+        for (int i = 0; i < StdioCount; ++i)
+            close(fds[i]);
+        return false;
+    }
+    environment->resize(size);
+    if (!readFully(socket, environment->data(), size)) {
+        for (int i = 0; i < StdioCount; ++i)
+            close(fds[i]);
+        return false;
+    }
+    return true;
+}
+
+void becomeGreeter(int fds[StdioCount], const QByteArray &environment)
+{
+    // Die with the zygote, greetd only knows about the connecting process.
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+    signal(SIGPIPE, SIG_DFL);
+
+    for (int i = 0; i < StdioCount; ++i) {
+        dup2(fds[i], i);
+        if (fds[i] >= StdioCount)
+            close(fds[i]);
+    }
+
+    // E.g. XDG_SESSION_ID of an earlier greeter mustn't survive.
+    QList<QByteArray> stale;
+    for (char **entry = environ; *entry; ++entry) {
+        const QByteArray name = QByteArray(*entry).section('=', 0, 0);
+        if (isForwardedVariable(name))
+            stale << name;
+    }
+    for (const QByteArray &name : std::as_const(stale))
+        unsetenv(name.constData());
+
+    for (const QByteArray &entry : environment.split('\0')) {
+        const int separator = entry.indexOf('=');
+        const QByteArray name = entry.left(separator);
+        if (separator > 0 && isForwardedVariable(name))
+            setenv(name.constData(), entry.mid(separator + 1).constData(), 1);
+    }
+}
+
+int waitForGreeter(pid_t pid, int client)
+{
+    // The connecting process is gone when greetd stops the greeter.
+    const int pidfd = int(syscall(SYS_pidfd_open, pid, 0));
+    if (pidfd >= 0) {
+        pollfd fds[] = { { pidfd, POLLIN, 0 }, { client, POLLIN, 0 } };
+        while (poll(fds, 2, -1) < 0 && errno == EINTR) { }
+        if (!(fds[0].revents & POLLIN)) {
+            qCInfo(qLcZygote) << "Client went away, stopping greeter" << pid;
+            kill(pid, SIGTERM);
+        }
+        close(pidfd);
+    }
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) { }
+    if (WIFEXITED(status))
+        return WEXITSTATUS(status);
+    return 128 + WTERMSIG(status);
+}
+
+} // namespace
+
+namespace Zygote {
+
+bool serve(const QString &socketPath, int *exitCode)
+{
+    *exitCode = 1;
+
+    if (!prepareSocketDirectory(socketPath))
+        return false;
+
+    const int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    const sockaddr_un address = socketAddress(socketPath);
+    unlink(address.sun_path);
+    const mode_t umaskBefore = umask(077);
+    if (listener < 0
+        || bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0
+        || listen(listener, 1) < 0) {
+        qCCritical(qLcZygote) << "Can't listen on" << socketPath << strerror(errno);
+        umask(umaskBefore);
+        return false;
+    }
+    umask(umaskBefore);
+
+    // A client that went away must not take the zygote with it.
+    signal(SIGPIPE, SIG_IGN);
+
+    // No QCoreApplication yet, QSettings and NSS work without one.
+    auto config = new WayConfig;
+    warmCaches();
+    qCInfo(qLcZygote) << "Waiting for greeters on" << socketPath;
+
+    while (true) {
+        const int client = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            if (errno == EINTR)
+                continue;
+            qCCritical(qLcZygote) << "Accepting failed:" << strerror(errno);
+            break;
+        }
+
+        if (!isGreeterUser(client)) {
+            qCWarning(qLcZygote) << "Rejected a client of another user";
+            close(client);
+            continue;
+        }
+
+        int fds[StdioCount];
+        QByteArray environment;
+        if (!receiveRequest(client, fds, &environment)) {
+            qCWarning(qLcZygote) << "Invalid request";
+            close(client);
+            continue;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        const pid_t pid = fork();
+        if (pid == 0) {
+            close(listener);
+            close(client);
+            becomeGreeter(fds, environment);
+            // The greeter's QML singleton replaces it.
+            delete config;
+            // Time to the greeter's first frame, see --startup-trace.
+            StartupTrace::mark("forked by zygote");
+            return true;
+        }
+
+        for (int i = 0; i < StdioCount; ++i)
+            close(fds[i]);
+        if (pid < 0) {
+            qCWarning(qLcZygote) << "Fork failed:" << strerror(errno);
+            close(client);
+            continue;
+        }
+        qCInfo(qLcZygote) << "Forked greeter" << pid << "in" << timer.nsecsElapsed() / 1000
+                          << "us";
+
+        const qint32 code = waitForGreeter(pid, client);
+        qCInfo(qLcZygote) << "Greeter" << pid << "exited with" << code;
+        writeFully(client, &code, sizeof(code));
+        close(client);
+
+        // Ready for the next login, without competing with this greeter.
+        warmCachesAtIdlePriority();
+    }
+
+    close(listener);
+    delete config;
+    return false;
+}
+
+bool connect(const QString &socketPath, int *exitCode)
+{
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    const sockaddr_un address = socketAddress(socketPath);
+    if (fd < 0
+        || ::connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0) {
+        qCWarning(qLcZygote) << "No zygote on" << socketPath << "starting normally";
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+
+    QByteArray environment;
+    for (char **entry = environ; *entry; ++entry)
+        environment.append(*entry).append('\0');
+
+    quint32 size = environment.size();
+    iovec iov{ &size, sizeof(size) };
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * StdioCount)]{};
+    msghdr message{};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    cmsghdr *header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int) * StdioCount);
+    const int fds[StdioCount] = { STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO };
+    memcpy(CMSG_DATA(header), fds, sizeof(fds));
+
+    ssize_t n;
+    do {
+        n = sendmsg(fd, &message, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+
+    qint32 code = 1;
+    if (n != sizeof(size) || !writeFully(fd, environment.constData(), environment.size())
+        || !readFully(fd, &code, sizeof(code))) {
+        qCWarning(qLcZygote) << "Lost the zygote on" << socketPath;
+    }
+    close(fd);
+
+    *exitCode = code;
+    return true;
+}
+
+} // namespace Zygote
@@ -0,0 +1,26 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <QString>
+
+// Warm standby for terminals with frequent logins. `waygreet --zygote <socket>`
+// stays running, keeps the user list and the theme and session files warm, and
+// forks a greeter for each `waygreet --zygote-connect <socket>` greetd starts.
+// The connecting process passes its stdio and environment over the socket and
+// exits with the forked greeter's status.
+//
+// The zygote stops before QGuiApplication: the renderer, the QML engine and
+// the Wayland server own threads and device file descriptors that can't be
+// shared with a forked child, so each greeter still creates them.
+namespace Zygote {
+
+// Returns true in each forked greeter, which then starts like a normal one.
+// Returns false with the zygote's exit code if it can't serve anymore.
+bool serve(const QString &socketPath, int *exitCode);
+
+// Returns false if no zygote is listening, the caller then starts normally.
+bool connect(const QString &socketPath, int *exitCode);
+
+} // namespace Zygote
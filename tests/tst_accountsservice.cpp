@@ -0,0 +1,251 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "usermodel.h"
+#include "wayconfig.h"
+
+#include <QDBusConnection>
+#include <QDBusObjectPath>
+#include <QProcess>
+#include <QSettings>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTest>
+
+// Stand-in for an org.freedesktop.Accounts.User object.
+class FakeUser : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.Accounts.User")
+    Q_PROPERTY(QString UserName MEMBER userName)
+    Q_PROPERTY(QString RealName MEMBER realName)
+    Q_PROPERTY(QString HomeDirectory MEMBER homeDirectory)
+    Q_PROPERTY(QString IconFile MEMBER iconFile)
+    Q_PROPERTY(qulonglong Uid MEMBER uid)
+    Q_PROPERTY(bool SystemAccount MEMBER systemAccount)
+    Q_PROPERTY(int PasswordMode MEMBER passwordMode)
+
+public:
+    FakeUser(const QString &name, qulonglong uid, QObject *parent)
+        : QObject(parent)
+        , userName(name)
+        , realName(name)
+        , homeDirectory(QStringLiteral("/home/") + name)
+        , uid(uid)
+    {
+    }
+
+    QString path() const { return QStringLiteral("/org/freedesktop/Accounts/User%1").arg(uid); }
+
+    QString userName;
+    QString realName;
+    QString homeDirectory;
+    QString iconFile;
+    qulonglong uid;
+    bool systemAccount{ false };
+    int passwordMode{ 0 };
+
+Q_SIGNALS:
+    void Changed();
+};
+
+// Stand-in for the org.freedesktop.Accounts service, on a private bus.
+class FakeAccounts : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.Accounts")
+
+public:
+    explicit FakeAccounts(const QDBusConnection &bus)
+        : m_bus(bus)
+    {
+    }
+
+    FakeUser *addUser(const QString &name, qulonglong uid)
+    {
+        auto user = new FakeUser(name, uid, this);
+        m_bus.registerObject(user->path(),
+                             user,
+                             QDBusConnection::ExportAllProperties
+                                 | QDBusConnection::ExportAllSignals);
+        m_users << user;
+        Q_EMIT UserAdded(QDBusObjectPath(user->path()));
+        return user;
+    }
+
+    void deleteUser(FakeUser *user)
+    {
+        m_users.removeOne(user);
+        m_bus.unregisterObject(user->path());
+        Q_EMIT UserDeleted(QDBusObjectPath(user->path()));
+        user->deleteLater();
+    }
+
+public Q_SLOTS:
+    QList<QDBusObjectPath> ListCachedUsers() const
+    {
+        QList<QDBusObjectPath> paths;
+        for (auto user : m_users)
+            paths << QDBusObjectPath(user->path());
+        return paths;
+    }
+
+Q_SIGNALS:
+    void UserAdded(const QDBusObjectPath &user);
+    void UserDeleted(const QDBusObjectPath &user);
+
+private:
+    QDBusConnection m_bus;
+    QList<FakeUser *> m_users;
+};
+
+class TestAccountsService : public QObject
+{
+    Q_OBJECT
+
+public:
+    static void initMain()
+    {
+        // Keeps QSettings away from the real configuration.
+        QStandardPaths::setTestModeEnabled(true);
+    }
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void followsService();
+    void changedWhileLoading();
+    void clearKeepsSelection();
+
+private:
+    QProcess m_daemon;
+    QString m_address;
+    FakeAccounts *m_accounts{ nullptr };
+    WayConfig *m_config{ nullptr };
+};
+
+void TestAccountsService::initTestCase()
+{
+    const QString daemon = QStandardPaths::findExecutable(QStringLiteral("dbus-daemon"));
+    if (daemon.isEmpty())
+        QSKIP("dbus-daemon is not installed");
+
+    m_daemon.start(daemon, { "--session", "--nofork", "--print-address" });
+    QVERIFY(m_daemon.waitForReadyRead(5000));
+    m_address = QString::fromUtf8(m_daemon.readLine()).trimmed();
+    QVERIFY(!m_address.isEmpty());
+
+    auto bus = QDBusConnection::connectToBus(m_address, QStringLiteral("fake-accounts"));
+    QVERIFY(bus.isConnected());
+    QVERIFY(bus.registerService(QStringLiteral("org.freedesktop.Accounts")));
+    m_accounts = new FakeAccounts(bus);
+    QVERIFY(bus.registerObject(QStringLiteral("/org/freedesktop/Accounts"),
+                               m_accounts,
+                               QDBusConnection::ExportAllSlots
+                                   | QDBusConnection::ExportAllSignals));
+    m_accounts->addUser(QStringLiteral("alice"), 1001);
+
+    QSettings settings("dwapp", "waygreet");
+    settings.clear();
+    settings.setValue("userBackend", "accountsservice");
+    settings.setValue("accountsServiceBus", m_address);
+    settings.setValue("hideUsers", "");
+    settings.sync();
+    m_config = new WayConfig(this);
+}
+
+void TestAccountsService::cleanupTestCase()
+{
+    delete m_config;
+    delete m_accounts;
+    QDBusConnection::disconnectFromBus(QStringLiteral("fake-accounts"));
+    m_daemon.kill();
+    m_daemon.waitForFinished();
+}
+
+void TestAccountsService::followsService()
+{
+    UserModel model(true);
+    model.load();
+    QTRY_VERIFY(model.containsAllUsers());
+    QCOMPARE(model.rowCount(), 1);
+
+    QStringList events;
+    connect(&model,
+            &QAbstractItemModel::rowsInserted,
+            this,
+            [&events](const QModelIndex &, int first, int) {
+                events << QStringLiteral("inserted %1").arg(first);
+            });
+    connect(&model,
+            &QAbstractItemModel::rowsRemoved,
+            this,
+            [&events](const QModelIndex &, int first, int) {
+                events << QStringLiteral("removed %1").arg(first);
+            });
+    connect(&model, &QAbstractItemModel::dataChanged, this, [&events](const QModelIndex &first) {
+        events << QStringLiteral("changed %1").arg(first.row());
+    });
+    QSignalSpy resets(&model, &QAbstractItemModel::modelReset);
+
+    // Sorted by name, after alice.
+    auto bob = m_accounts->addUser(QStringLiteral("bob"), 1002);
+    QTRY_COMPARE(events, QStringList{ "inserted 1" });
+    QCOMPARE(model.data(model.index(1), UserModel::NameRole).toString(), QStringLiteral("bob"));
+
+    bob->realName = QStringLiteral("Bob Builder");
+    Q_EMIT bob->Changed();
+    QTRY_COMPARE(events, (QStringList{ "inserted 1", "changed 1" }));
+    QCOMPARE(model.data(model.index(1), UserModel::RealNameRole).toString(),
+             QStringLiteral("Bob Builder"));
+
+    m_accounts->deleteUser(bob);
+    QTRY_COMPARE(events, (QStringList{ "inserted 1", "changed 1", "removed 1" }));
+    QCOMPARE(model.rowCount(), 1);
+
+    // Incremental, the view keeps its state.
+    QCOMPARE(resets.count(), 0);
+}
+
+void TestAccountsService::changedWhileLoading()
+{
+    UserModel model(true);
+    model.load();
+
+    // While the model is still loading, the change must not be lost.
+    auto carol = m_accounts->addUser(QStringLiteral("carol"), 1003);
+    carol->realName = QStringLiteral("Carol");
+    Q_EMIT carol->Changed();
+
+    QTRY_VERIFY(model.containsAllUsers());
+    QTRY_COMPARE(model.rowCount(), 2);
+    QTRY_COMPARE(model.data(model.index(1), UserModel::RealNameRole).toString(),
+                 QStringLiteral("Carol"));
+
+    m_accounts->deleteUser(carol);
+    QTRY_COMPARE(model.rowCount(), 1);
+}
+
+void TestAccountsService::clearKeepsSelection()
+{
+    auto bob = m_accounts->addUser(QStringLiteral("bob"), 1002);
+    UserModel model(true);
+    model.load();
+    QTRY_COMPARE(model.rowCount(), 2);
+    model.current()->setIndex(1);
+    QCOMPARE(model.current()->name(), QStringLiteral("bob"));
+
+    // As after a failed login, bob is still selected instead of the last user.
+    model.clear();
+    QCOMPARE(model.rowCount(), 0);
+    model.load();
+    QTRY_COMPARE(model.rowCount(), 2);
+    QCOMPARE(model.current()->name(), QStringLiteral("bob"));
+
+    m_accounts->deleteUser(bob);
+    QTRY_COMPARE(model.rowCount(), 1);
+}
+
+QTEST_GUILESS_MAIN(TestAccountsService)
+
+#include "tst_accountsservice.moc"
@@ -0,0 +1,80 @@
+// Copyright (C) 2025 rewine <luhongxu@deepin.org>.
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "backgroundcache.h"
+
+#include <QDir>
+#include <QQuickTextureFactory>
+#include <QScopeGuard>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <memory>
+
+class TestBackgroundCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static void initMain()
+    {
+        // Keeps the rendered variants out of the real cache directory.
+        QStandardPaths::setTestModeEnabled(true);
+    }
+
+private Q_SLOTS:
+    void variant_data();
+    void variant();
+};
+
+void TestBackgroundCache::variant_data()
+{
+    QTest::addColumn<int>("fillMode");
+    QTest::addColumn<int>("blurRadius");
+
+    QTest::newRow("stretch") << int(BackgroundCache::Stretch) << 0;
+    QTest::newRow("crop, blurred") << int(BackgroundCache::PreserveAspectCrop) << 4;
+}
+
+void TestBackgroundCache::variant()
+{
+    QFETCH(int, fillMode);
+    QFETCH(int, blurRadius);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("bg.png"));
+    QImage source(64, 48, QImage::Format_ARGB32_Premultiplied);
+    source.fill(Qt::darkCyan);
+    QVERIFY(source.save(path));
+
+    // Not `/`, a relative path must not resolve by chance.
+    const QString previousDir = QDir::currentPath();
+    QDir::setCurrent(dir.path());
+    auto restoreDir = qScopeGuard([&previousDir] { QDir::setCurrent(previousDir); });
+
+    BackgroundCache cache;
+    auto provider = std::make_unique<BackgroundImageProvider>();
+    const QUrl url = cache.variant(QUrl::fromLocalFile(path), blurRadius, fillMode);
+    QCOMPARE(url.scheme(), QStringLiteral("image"));
+    QCOMPARE(url.host(), QStringLiteral("background"));
+
+    // The id as QQuickPixmap passes it to the provider.
+    const QString id = url.toString(QUrl::RemoveScheme | QUrl::RemoveAuthority).mid(1);
+    const QSize size(32, 32);
+    std::unique_ptr<QQuickImageResponse> response(provider->requestImageResponse(id, size));
+    // Waits for its thread pool, finished() may be emitted before any
+    // connection could be made.
+    provider.reset();
+
+    std::unique_ptr<QQuickTextureFactory> factory(response->textureFactory());
+    QVERIFY(factory);
+    const QImage image = factory->image();
+    QVERIFY(!image.isNull());
+    QCOMPARE(image.size(), size);
+}
+
+QTEST_GUILESS_MAIN(TestBackgroundCache)
+
+#include "tst_backgroundcache.moc"
@@ -53,7 +53,7 @@ Item {
             textRole: "name"
             currentIndex: Helper.sessionModel.lastIndex
             Layout.fillWidth: true
-            visible: Helper.sessionModel.rowCount() > 0
+            visible: Helper.sessionModel.count > 0
             onCurrentIndexChanged: {
                 Helper.sessionModel.setLastIndex(currentIndex)
             }
@@ -2,8 +2,6 @@ import QtQuick 2.15
 import QtQuick.Controls 2.0
 import WayGreet
 
-import Qt5Compat.GraphicalEffects
-
 Rectangle {
     id: root
 
@@ -11,42 +9,31 @@ Rectangle {
 
     anchors.fill: parent
 
-    readonly property color textColor: config.stringValue("basicTextColor")
-    property int currentUsersIndex: Helper.userModel.lastIndex
-    property int currentSessionsIndex: Helper.sessionModel.lastIndex
-    property int usernameRole: Qt.UserRole + 1
-    property int realNameRole: Qt.UserRole + 2
-    property int sessionNameRole: Qt.UserRole + 4
-    property string currentUsername: config.boolValue("showUserRealNameByDefault") ?
-    Helper.userModel.data(Helper.userModel.index(currentUsersIndex, 0), realNameRole)
-    : Helper.userModel.data(Helper.userModel.index(currentUsersIndex, 0), usernameRole)
-    property string currentSession: Helper.sessionModel.data(Helper.sessionModel.index(currentSessionsIndex, 0), sessionNameRole)
-    property string passwordFontSize: config.intValue("passwordFontSize") || 96
-    property string usersFontSize: config.intValue("usersFontSize") || 48
-    property string sessionsFontSize: config.intValue("sessionsFontSize") || 24
-    property string helpFontSize: config.intValue("helpFontSize") || 18
-    property string defaultFont: config.stringValue("font") || "monospace"
-    property string helpFont: config.stringValue("helpFont") || defaultFont
+    // The parent is the output item, variants are rendered at device pixels.
+    readonly property real outputScale: parent?.devicePixelRatio ?? 1
+    readonly property color textColor: config.basicTextColor ?? "#ffffff"
+    readonly property QtObject currentUser: Helper.userModel.current
+    readonly property QtObject currentSessionItem: Helper.sessionModel.current
+    property string currentUsername: config.showUserRealNameByDefault ? currentUser.realName : currentUser.name
+    property string currentSession: currentSessionItem.name
+    property string passwordFontSize: config.passwordFontSize || 96
+    property string usersFontSize: config.usersFontSize || 48
+    property string sessionsFontSize: config.sessionsFontSize || 24
+    property string helpFontSize: config.helpFontSize || 18
+    property string defaultFont: config.font?.family || "monospace"
+    property string helpFont: config.helpFont?.family || defaultFont
 
 
     function usersCycleSelectPrev() {
-        if (currentUsersIndex - 1 < 0) {
-            currentUsersIndex = Helper.userModel.count - 1;
-        } else {
-            currentUsersIndex--;
-        }
+        currentUser.selectPrevious();
     }
 
     function usersCycleSelectNext() {
-        if (currentUsersIndex >= Helper.userModel.count - 1) {
-            currentUsersIndex = 0;
-        } else {
-            currentUsersIndex++;
-        }
+        currentUser.selectNext();
     }
 
     function bgFillMode() {
-        switch(config.stringValue("backgroundFillMode"))
+        switch(config.backgroundFillMode)
         {
             case "aspect":
                 return Image.PreserveAspectCrop;
@@ -66,19 +53,11 @@ Rectangle {
     }
 
     function sessionsCycleSelectPrev() {
-        if (currentSessionsIndex - 1 < 0) {
-            currentSessionsIndex = Helper.sessionModel.rowCount() - 1;
-        } else {
-            currentSessionsIndex--;
-        }
+        currentSessionItem.selectPrevious();
     }
 
     function sessionsCycleSelectNext() {
-        if (currentSessionsIndex >= Helper.sessionModel.rowCount() - 1) {
-            currentSessionsIndex = 0;
-        } else {
-            currentSessionsIndex++;
-        }
+        currentSessionItem.selectNext();
     }
 
 
@@ -177,11 +156,21 @@ Rectangle {
             id: background
             visible: true
             anchors.fill: parent
-            color: config.stringValue("backgroundFill") || "transparent"
+            color: config.backgroundFill || "transparent"
             Image {
                 id: image
                 anchors.fill: parent
-                source: config.stringValue("background") || WayConfig.background
+                // Scaled as fillMode would and blurred once by BackgroundCache, off the
+                // GUI thread. No shader blur per frame.
+                source: width > 0 && height > 0
+                        ? BackgroundCache.variant(config.background || WayConfig.background,
+                                                  config.blurRadius || 0, fillMode)
+                        : ""
+                sourceSize: fillMode === Image.Stretch || fillMode === Image.PreserveAspectFit
+                            || fillMode === Image.PreserveAspectCrop
+                            ? Qt.size(Math.ceil(width * root.outputScale),
+                                      Math.ceil(height * root.outputScale))
+                            : undefined
                 smooth: true
                 fillMode: bgFillMode()
                 z: 2
@@ -191,8 +180,8 @@ Rectangle {
                 id: backgroundBorder
                 anchors.fill: parent
                 z: 4
-                radius: config.stringValue("wrongPasswordBorderRadius") || 0
-                border.color: config.stringValue("wrongPasswordBorderColor") || "#ff3117"
+                radius: config.wrongPasswordBorderRadius || 0
+                border.color: config.wrongPasswordBorderColor || "#ff3117"
                 border.width: 0
                 color: "transparent"
                 Behavior on border.width {
@@ -206,19 +195,11 @@ Rectangle {
                 }
             }
 
-            FastBlur {
-                id: fastBlur
-                z: 3
-                anchors.fill: image
-                source: image
-                radius: config.intValue("blurRadius")
-            }
-
         }
 
         TextInput {
             id: passwordInput
-            width: parent.width*(config.realValue("passwordInputWidth") || 0.5)
+            width: parent.width*(config.passwordInputWidth || 0.5)
             height: 200/96*passwordFontSize
             font.pointSize: passwordFontSize
             font.bold: true
@@ -228,28 +209,40 @@ Rectangle {
                 verticalCenter: parent.verticalCenter
                 horizontalCenter: parent.horizontalCenter
             }
-            echoMode: config.boolValue("passwordMask") ? TextInput.Password : TextInput.Normal
-            color: config.stringValue("passwordTextColor") || textColor
+            echoMode: (config.passwordMask ?? false) ? TextInput.Password : TextInput.Normal
+            color: config.passwordTextColor || textColor
             selectionColor: textColor
             selectedTextColor: "#000000"
             clip: true
             horizontalAlignment: TextInput.AlignHCenter
             verticalAlignment: TextInput.AlignVCenter
-            passwordCharacter: config.stringValue("passwordCharacter") || "*"
-            cursorVisible: config.boolValue("passwordInputCursorVisible")
+            passwordCharacter: config.passwordCharacter || "*"
+            cursorVisible: config.passwordInputCursorVisible ?? false
+            // Stop blinking after a while without typing, like gtk-cursor-blink-timeout,
+            // so an idle greeter doesn't render a frame for every blink.
+            property bool cursorBlinking: true
+            onTextEdited: {
+                cursorBlinking = true;
+                cursorBlinkTimeout.restart();
+            }
+            Timer {
+                id: cursorBlinkTimeout
+                interval: 10000
+                running: true
+                onTriggered: passwordInput.cursorBlinking = false
+            }
             onAccepted: {
-                if (text != "" || config.boolValue("passwordAllowEmpty")) {
-                    Helper.login(Helper.userModel.data(Helper.userModel.index(currentUsersIndex, 0), usernameRole)
- || "123test", text, currentSessionsIndex);
+                if (text != "" || (config.passwordAllowEmpty ?? false)) {
+                    Helper.login(currentUser.name || "123test", text, currentSessionItem.index);
                 }
             }
             Rectangle {
                 z: -1
                 anchors.fill: parent
-                color: config.stringValue("passwordInputBackground") || "transparent"
-                radius: config.intValue("passwordInputRadius") || 10
-                border.width: config.intValue("passwordInputBorderWidth") || 0
-                border.color: config.stringValue("passwordInputBorderColor") || "#ffffff"
+                color: config.passwordInputBackground || "transparent"
+                radius: config.passwordInputRadius || 10
+                border.width: config.passwordInputBorderWidth || 0
+                border.color: config.passwordInputBorderColor || "#ffffff"
             }
             cursorDelegate: Rectangle {
                 function getCursorColor() {
@@ -264,7 +257,7 @@ Rectangle {
                 }
                 id: passwordInputCursor
                 width: 18/96*passwordFontSize
-                visible: config.boolValue("passwordInputCursorVisible")
+                visible: config.passwordInputCursorVisible ?? false
                 onHeightChanged: height = passwordInput.height/2
                 anchors.verticalCenter: parent.verticalCenter
                 color: getCursorColor()
@@ -277,7 +270,8 @@ Rectangle {
 				        PauseAnimation { duration: 500 }
                         ColorAnimation { from: "transparent"; to: currentColor; duration: 0 }
 				        PauseAnimation { duration: 400 }
-				        running: config.boolValue("cursorBlinkAnimation")
+				        running: (config.cursorBlinkAnimation ?? false) && passwordInput.cursorBlinking
+				        onStopped: passwordInputCursor.color = passwordInputCursor.getCursorColor()
 				}
 
                 function generateRandomColor() {
@@ -305,7 +299,7 @@ Rectangle {
         UsersChoose {
             id: username
             text: currentUsername
-            visible: config.boolValue("showUsersByDefault")
+            visible: config.showUsersByDefault ?? false
             width: mainFrame.width/2.5/48*usersFontSize
             anchors {
                 horizontalCenter: parent.horizontalCenter
@@ -323,7 +317,7 @@ Rectangle {
         SessionsChoose {
             id: sessionName
             text: currentSession
-            visible: config.boolValue("showSessionsByDefault")
+            visible: config.showSessionsByDefault ?? false
             width: mainFrame.width/2.5/24*sessionsFontSize
             anchors {
                 horizontalCenter: parent.horizontalCenter
@@ -367,7 +361,7 @@ Rectangle {
     }
 
     Loader {
-        active: config.boolValue("hideCursor") || false
+        active: config.hideCursor || false
         anchors.fill: parent
         sourceComponent: MouseArea {
             enabled: false